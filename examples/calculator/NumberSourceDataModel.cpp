@@ -85,6 +85,7 @@ onTextEdited(QString const& str)
   {
     _number = std::make_shared<DecimalData>(number);
 
+    Q_EMIT internalDataChanged();
     Q_EMIT dataUpdated(0);
   }
   else
@@ -137,6 +138,7 @@ setNumber(double n)
 {
   _number = std::make_shared<DecimalData>(n);
 
+  Q_EMIT internalDataChanged();
   Q_EMIT dataUpdated(0);
 
   if(_lineEdit)
@@ -97,7 +97,12 @@ connectionExists(ConnectionId const connectionId) const
                     PortType::Out,
                     getPortIndex(PortType::Out, connectionId));
 
-  return (_connectivity.find(key) != _connectivity.end());
+  auto it = _connectivity.find(key);
+
+  // The output port may feed other inputs, the edge itself must be there.
+  return (it != _connectivity.end()) &&
+         (it->second.count(std::make_pair(getNodeId(PortType::In, connectionId),
+                                          getPortIndex(PortType::In, connectionId))) > 0);
 }
 
 
@@ -203,6 +208,10 @@ nodeData(NodeId nodeId, NodeRole role) const
     }
     break;
 
+    case NodeRole::StyleIndex:
+      result = 0;
+      break;
+
     case NodeRole::InternalData:
       break;
 
@@ -262,6 +271,9 @@ setNodeData(NodeId   nodeId,
     case NodeRole::Style:
       break;
 
+    case NodeRole::StyleIndex:
+      break;
+
     case NodeRole::InternalData:
       break;
 
@@ -4,6 +4,7 @@
 
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 #include <QtCore/QObject>
 #include <QtCore/QVariant>
@@ -197,6 +198,77 @@ public:
   void
   loadNode(QJsonObject const &) {}
 
+  /**
+   * Restores a batch of nodes saved with `saveNode`. The default
+   * implementation calls `loadNode` for every element; models which
+   * are able to decode the nodes concurrently may reimplement it.
+   */
+  virtual
+  void
+  loadNodes(std::vector<QJsonObject> const & nodesJson)
+  {
+    for (auto const & nodeJson : nodesJson)
+    {
+      loadNode(nodeJson);
+    }
+  }
+
+  /**
+   * Restores nodes saved with `saveNode` and the connections between
+   * them (or to the nodes already present) as one batch. Used to undo
+   * the deletion of a large selection.
+   *
+   * The default implementation emits `batchUpdateStarted`, calls
+   * `loadNodes` and `addConnection` and emits `batchUpdateFinished`.
+   */
+  virtual
+  void
+  loadSubgraph(std::vector<QJsonObject> const &  nodesJson,
+               std::vector<ConnectionId> const & connectionIds)
+  {
+    Q_EMIT batchUpdateStarted();
+
+    loadNodes(nodesJson);
+
+    for (auto const & connectionId : connectionIds)
+    {
+      // The output port may keep other edges, look for this one.
+      if (connections(connectionId.outNodeId,
+                      PortType::Out,
+                      connectionId.outPortIndex).count(connectionId) == 0)
+        addConnection(connectionId);
+    }
+
+    Q_EMIT batchUpdateFinished();
+  }
+
+  /**
+   * Deletes the connections and then the nodes as one batch.
+   *
+   * The default implementation wraps `deleteConnection` and
+   * `deleteNode` calls into `batchUpdateStarted` and
+   * `batchUpdateFinished`.
+   */
+  virtual
+  void
+  deleteSubgraph(std::vector<NodeId> const &       nodeIds,
+                 std::vector<ConnectionId> const & connectionIds)
+  {
+    Q_EMIT batchUpdateStarted();
+
+    for (auto const & connectionId : connectionIds)
+    {
+      deleteConnection(connectionId);
+    }
+
+    for (NodeId const nodeId : nodeIds)
+    {
+      deleteNode(nodeId);
+    }
+
+    Q_EMIT batchUpdateFinished();
+  }
+
   virtual
   QJsonObject
   saveConnection(ConnectionId const & connId) const = 0;
@@ -229,6 +301,25 @@ Q_SIGNALS:
   void
   nodePositionUpdated(NodeId const nodeId);
 
+  /// Signal emitted when the node's internal state or caption was changed.
+  void
+  nodeUpdated(NodeId const nodeId);
+
+  /// The NodeRole::Style and NodeRole::StyleIndex of the node changed.
+  void
+  nodeStyleChanged(NodeId const nodeId);
+
+  /**
+   * Signals enclosing a series of node and connection insertions or
+   * removals. Views may defer their updates until the batch finishes.
+   * Batches may be nested.
+   */
+  void
+  batchUpdateStarted();
+
+  void
+  batchUpdateFinished();
+
   void
   inPortDataWasSet(NodeId const    nodeId,
                    PortType const  portType,
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <unordered_set>
+
+
+namespace QtNodes
+{
+
+class DataFlowGraphModel;
+
+/// Incremental autosave for DataFlowGraphModel.
+/**
+ * Instead of regenerating the whole JSON on every autosave the journal
+ * appends compact binary change records to `<basePath>.journal` as the
+ * model signals fire. Frequent changes (moves, internal data updates,
+ * freshly created nodes) are coalesced and written on the next flush.
+ * Internal data is recorded on `nodeUpdated`, which the model emits
+ * when a delegate model signals `NodeDelegateModel::internalDataChanged`.
+ *
+ * When the journal grows over the compaction threshold it is folded
+ * into a full snapshot, `<basePath>.snapshot`, and truncated. Both
+ * files carry a generation number, so a crash in the middle of the
+ * compaction never replays stale records.
+ *
+ * After a crash `recover()` loads the last snapshot into an empty model
+ * and replays the journal on top of it.
+ */
+class NODE_EDITOR_PUBLIC AutosaveJournal : public QObject
+{
+  Q_OBJECT
+
+public:
+  AutosaveJournal(DataFlowGraphModel &graphModel,
+                  QString const & basePath,
+                  QObject * parent = nullptr);
+
+  ~AutosaveJournal() override;
+
+public:
+  QString
+  snapshotFileName() const;
+
+  QString
+  journalFileName() const;
+
+  /// @returns `true` if a snapshot from a previous session exists.
+  bool
+  hasRecoveryData() const;
+
+  /// Restores the last autosaved state into the (empty) model.
+  /**
+   * Must be called before `start()`.
+   */
+  bool
+  recover();
+
+  /// Writes a fresh snapshot and starts recording model changes.
+  bool
+  start();
+
+  void
+  stop();
+
+  bool
+  isRecording() const { return _recording; }
+
+  /// Stops recording and removes the autosave files.
+  void
+  discard();
+
+  /// Maximum delay before coalesced changes reach the journal.
+  void
+  setFlushInterval(int msec);
+
+  /// Journal size in bytes after which the journal is compacted.
+  void
+  setCompactionThreshold(qint64 bytes);
+
+public Q_SLOTS:
+  /// Writes the coalesced changes and flushes the journal file.
+  void
+  flush();
+
+  /// Replaces the snapshot with the current model state and truncates
+  /// the journal.
+  bool
+  compact();
+
+private Q_SLOTS:
+  void
+  onNodeCreated(NodeId const nodeId);
+
+  void
+  onNodeDeleted(NodeId const nodeId);
+
+  void
+  onNodePositionUpdated(NodeId const nodeId);
+
+  void
+  onNodeUpdated(NodeId const nodeId);
+
+  void
+  onConnectionCreated(ConnectionId const connectionId);
+
+  void
+  onConnectionDeleted(ConnectionId const connectionId);
+
+private:
+  enum class RecordType : quint8
+  {
+    NodeAdded           = 1,
+    NodeRemoved         = 2,
+    NodeMoved           = 3,
+    ConnectionAdded     = 4,
+    ConnectionRemoved   = 5,
+    InternalDataChanged = 6,
+  };
+
+  void
+  scheduleFlush();
+
+  void
+  writePending();
+
+  void
+  appendRecord(RecordType type, QByteArray const & payload);
+
+  void
+  appendConnectionRecord(RecordType type, ConnectionId const & connectionId);
+
+  bool
+  openJournal(bool truncate);
+
+  bool
+  replayJournal();
+
+private:
+  DataFlowGraphModel &_graphModel;
+
+  QString _basePath;
+
+  bool _recording;
+
+  quint64 _generation;
+
+  qint64 _compactionThreshold;
+
+  QFile _journal;
+
+  QDataStream _stream;
+
+  QTimer _flushTimer;
+
+  std::unordered_set<NodeId> _pendingNodes;
+
+  std::unordered_set<NodeId> _pendingMoves;
+
+  std::unordered_set<NodeId> _pendingInternalData;
+};
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QUuid>
 #include <QtWidgets/QGraphicsScene>
 #include <QtWidgets/QMenu>
@@ -8,15 +9,18 @@
 #include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "AbstractGraphModel.hpp"
 #include "ConnectionIdHash.hpp"
 #include "Definitions.hpp"
 #include "Export.hpp"
+#include "NodeStyle.hpp"
 
 #include "QUuidStdHash.hpp"
 
 
+class QTimer;
 class QUndoStack;
 
 namespace QtNodes
@@ -24,8 +28,13 @@ namespace QtNodes
 
 class AbstractGraphModel;
 class ConnectionGraphicsObject;
+class ConnectionLayer;
 class NodeGraphicsObject;
-class NodeStyle;
+class NodeHeatmap;
+class NodePixmapCache;
+
+template <typename Key>
+class SpatialIndex;
 
 /// An instance of QGraphicsScene, holds connections and nodes.
 class NODE_EDITOR_PUBLIC BasicGraphicsScene : public QGraphicsScene
@@ -33,8 +42,17 @@ class NODE_EDITOR_PUBLIC BasicGraphicsScene : public QGraphicsScene
   Q_OBJECT
 public:
 
+  /// How the constructor creates the graphics objects of the model.
+  enum class PopulationMode
+  {
+    Immediate,   ///< All of them before the constructor returns.
+    Incremental, ///< In time-sliced chunks, nearest to the view first.
+  };
+  Q_ENUM(PopulationMode)
+
   BasicGraphicsScene(AbstractGraphModel &graphModel,
-                     QObject *    parent = nullptr);
+                     QObject *    parent = nullptr,
+                     PopulationMode populationMode = PopulationMode::Immediate);
 
   // Scenes without models are not supported
   BasicGraphicsScene() = delete;
@@ -81,12 +99,129 @@ public:
   void
   lockNode(NodeId const nodeId, bool locked);
 
+  /// Styles the nodes are switched to by `updateNodeStatuses`.
+  /**
+   * A node of status `i` is drawn with `styles[i]` instead of the
+   * style provided by the model. Negative and out of range statuses
+   * keep the style of the model.
+   */
+  void
+  setStatusStyles(std::vector<NodeStyle> styles);
+
+  /// Sets the status and the lock of many nodes in one pass.
+  /**
+   * Meant for monitoring, where every tick recolors and locks a large
+   * part of the graph. Nodes already in the requested state are
+   * skipped. The changed nodes and the connections entering them are
+   * repainted once on the next event loop iteration, however many
+   * updates arrive in between.
+   */
+  void
+  updateNodeStatuses(std::vector<std::pair<NodeId, int>> const & statuses,
+                     bool locked);
+
+  /// @returns -1 for the nodes without a status.
+  int
+  nodeStatus(NodeId const nodeId) const;
+
+  /// Style the node is drawn with, its status taken into account.
+  /**
+   * Resolved through NodeRole::StyleIndex without any copy. Only for
+   * models lacking the role the NodeRole::Style JSON is parsed, once per
+   * node until the model emits `nodeUpdated` or `nodeStyleChanged` for it.
+   */
+  NodeStyle const &
+  nodeStyle(NodeId const nodeId) const;
+
+  /// Bytes identifying the style of the node, for the pixmap cache keys.
+  /**
+   * The palette handle, or the NodeRole::Style JSON serialized along with
+   * its parsed style.
+   */
+  QByteArray
+  nodeStyleKey(NodeId const nodeId) const;
+
+  /// Heatmap drawn over the nodes, `nullptr` when none is shown.
+  /**
+   * Set by `NodeHeatmap::show()` and `NodeHeatmap::hide()`.
+   */
+  void
+  setHeatmap(NodeHeatmap const * heatmap);
+
+  NodeHeatmap const *
+  heatmap() const { return _heatmap; }
+
+  /// Repaints the nodes whose heat color changed, once per event loop iteration.
+  /**
+   * With `connections` the connections entering them are repainted as well.
+   */
+  void
+  updateHeatLevels(std::vector<NodeId> const & nodeIds, bool connections);
+
   void
   onPortLayoutUpdated(PortLayout layout);
 
   void
   onNodeColorUpdated(NodeId const nodeId);
 
+  /// Moves all the `nodeIds` by `diff` as one batch.
+  /**
+   * The attached connections are repositioned once, after all the
+   * nodes have moved, instead of once per moved endpoint.
+   */
+  void
+  translateNodes(std::unordered_set<NodeId> const & nodeIds,
+                 QPointF const &                    diff);
+
+  /// `true` while `translateNodes` is running.
+  bool
+  isTranslatingNodes() const { return _translatingNodes; }
+
+  /// Starts a new node drag gesture and @returns its id.
+  /**
+   * Move commands are merged in the undo stack only within one gesture.
+   */
+  int
+  beginNodeDrag() { return ++_nodeDragGesture; }
+
+  int
+  nodeDragGesture() const { return _nodeDragGesture; }
+
+  /// Limits the memory held by the undo history.
+  /**
+   * When the commands in the undo stack hold more than `bytes`, the
+   * oldest ones are evicted: their payload is freed and they are
+   * dropped from the history. The most recent command is always kept.
+   * `0` disables the limit (the default).
+   */
+  void
+  setUndoMemoryBudget(qint64 bytes);
+
+  qint64
+  undoMemoryBudget() const { return _undoMemoryBudget; }
+
+  /// Approximate number of bytes held by the undo history.
+  qint64
+  undoMemoryUsage() const;
+
+  /// Shares the rasterized images of identical-looking nodes.
+  /**
+   * With a positive budget the nodes are drawn from one scene-wide
+   * pixmap cache holding at most `bytes`, least recently used images
+   * are evicted first. Each node then stops caching its own image
+   * (`QGraphicsItem::DeviceCoordinateCache`). `0` restores the
+   * per-item caches (the default).
+   */
+  void
+  setNodeCacheBudget(qint64 bytes);
+
+  qint64
+  nodeCacheBudget() const;
+
+  /// @returns the shared node cache or `nullptr` when it is disabled.
+  NodePixmapCache *
+  nodePixmapCache() { return _nodePixmapCache.get(); }
+
 public:
 
   /// @returns NodeGraphicsObject associated with the given nodeId.
@@ -103,6 +238,130 @@ public:
   ConnectionGraphicsObject *
   connectionGraphicsObject(ConnectionId connectionId);
 
+  /// Nodes whose bounding rectangles intersect `sceneRect`.
+  /**
+   * The query goes through the scene's own spatial index, the
+   * QGraphicsScene item index is disabled.
+   */
+  std::vector<NodeGraphicsObject*>
+  nodesIn(QRectF const & sceneRect);
+
+  /// Connections whose bounding rectangles intersect `sceneRect`.
+  std::vector<ConnectionGraphicsObject*>
+  connectionsIn(QRectF const & sceneRect);
+
+  /// Selects the nodes and connections whose shapes intersect `sceneRect`.
+  /**
+   * The rubber band of GraphicsView goes through here, so that the
+   * candidates come from the spatial index. `ReplaceSelection`
+   * deselects the other items, `AddToSelection` keeps them.
+   */
+  void
+  setSelectionRect(QRectF const &             sceneRect,
+                   Qt::ItemSelectionOperation operation);
+
+  /// @returns the topmost node whose shape contains `scenePoint`.
+  NodeGraphicsObject *
+  nodeAt(QPointF const & scenePoint);
+
+  /// Schedules the re-indexing of the node's scene bounds.
+  void
+  invalidateNodeBounds(NodeId const nodeId);
+
+  /// Schedules the re-indexing of the connection's scene bounds.
+  void
+  invalidateConnectionBounds(ConnectionId const connectionId);
+
+  /// Keeps the selection sets in sync, called by the graphics objects.
+  void
+  recordNodeSelection(NodeId const nodeId, bool selected);
+
+  void
+  recordConnectionSelection(ConnectionId const connectionId, bool selected);
+
+public:
+
+  /// Keeps graphics objects only for the items near the visible area.
+  /**
+   * In the virtualized mode the scene indexes the model positions of
+   * all nodes and connections, but instantiates NodeGraphicsObject and
+   * ConnectionGraphicsObject only for the items intersecting the
+   * visible rectangle extended by the margin. The objects are released
+   * once they leave twice that margin, so small pans do not recreate
+   * them. Selected, hovered, grabbed and focused items are kept.
+   *
+   * Both ends of a materialized connection are materialized as well.
+   * `nodeGraphicsObject()` and `connectionGraphicsObject()` @return
+   * `nullptr` for the items outside the area.
+   */
+  void
+  setVirtualized(bool virtualized);
+
+  bool
+  isVirtualized() const { return _virtualized; }
+
+  /// Margin around the visible rectangle as a fraction of its size.
+  void
+  setVirtualizationMargin(qreal fraction);
+
+  qreal
+  virtualizationMargin() const { return _virtualizationMargin; }
+
+  /// Scene area shown by the view.
+  /**
+   * GraphicsView reports it on every scroll, zoom and resize. Other
+   * views have to call it themselves to use the virtualized mode.
+   * Nothing is materialized until the first rectangle is reported.
+   */
+  void
+  setVisibleRect(QRectF const & sceneRect);
+
+  QRectF
+  visibleRect() const { return _visibleRect; }
+
+  /// Time spent creating graphics objects per event loop iteration.
+  /**
+   * Used by PopulationMode::Incremental, 8 ms by default.
+   */
+  void
+  setPopulationBudget(int milliseconds);
+
+  int
+  populationBudget() const { return _populationBudget; }
+
+  /// `true` until the incremental population has completed.
+  bool
+  isPopulating() const;
+
+public:
+
+  /// Draws the established connections with one scene item.
+  /**
+   * Instead of a ConnectionGraphicsObject per connection, a single
+   * layer item paints all of them grouped by color and hit-tests them
+   * through its spatial index. Only the hovered, selected and grabbed
+   * connections, and the draft one, get their own graphics objects.
+   * They go back to the layer once released.
+   */
+  void
+  setConnectionLayer(bool enabled);
+
+  bool
+  hasConnectionLayer() const { return _connectionLayer != nullptr; }
+
+  /// @returns the ConnectionGraphicsObject of `connectionId`.
+  /**
+   * Creates the object when the connection is drawn by the layer or
+   * was released by the virtualization. @returns `nullptr` when the
+   * connection or one of its nodes has no graphics representation.
+   */
+  ConnectionGraphicsObject *
+  promoteConnection(ConnectionId const connectionId);
+
+  /// Repositions the connection after its nodes have moved.
+  void
+  updateConnectionGeometry(ConnectionId const connectionId);
+
 public:
 
   /// Can @return an instance of the scene context menu in subclass.
@@ -118,8 +377,11 @@ public:
   void
   cleanupSceneMenu(QMenu *menu);
 
+  /// Served from the scene's selection set, O(number of selected nodes).
   std::vector<NodeId> selectedNodes() const;
 
+  std::vector<ConnectionId> selectedConnections() const;
+
 Q_SIGNALS:
 
   void
@@ -156,13 +418,39 @@ Q_SIGNALS:
   void
   selectionRemoved();
 
+  /// Changes of the selection since the previous emission.
+  /**
+   * Emitted at most once per event loop iteration. Items selected and
+   * deselected again in between are not reported, deleted items are
+   * reported as deselected.
+   */
+  void
+  selectionSetChanged(std::vector<NodeId> const &       selectedNodes,
+                      std::vector<NodeId> const &       deselectedNodes,
+                      std::vector<ConnectionId> const & selectedConnections,
+                      std::vector<ConnectionId> const & deselectedConnections);
+
   void
   connectionRemoved();
 
   void
   connectionAdded();
 
+  /// Emitted after every chunk of the incremental population.
+  void
+  populationProgress(int createdNodes, int totalNodes);
+
+  void
+  populationCompleted();
+
 private:
+  struct ParsedNodeStyle
+  {
+    NodeStyle style;
+
+    /// The JSON it was parsed from, compact.
+    QByteArray key;
+  };
 
   /// @brief Creates Node and Connection graphics objects.
   /**
@@ -173,11 +461,68 @@ private:
   void
   traverseGraphAndPopulateGraphicsObjects();
 
+  /// Parses the NodeRole::Style JSON unless cached already.
+  ParsedNodeStyle const &
+  parsedNodeStyle(NodeId const nodeId) const;
+
+  /// Orders the pending nodes so that the nearest to the view come last.
+  void
+  sortPendingNodes();
+
+  /// `true` when both ends of the connection have graphics objects.
+  bool
+  canMaterializeConnection(ConnectionId const connectionId);
+
   /// Redraws adjacent nodes for given `connectionId`
   void
   updateAttachedNodes(ConnectionId const connectionId,
                       PortType const portType);
 
+  /// Creates NodeGraphicsObject or RootNodeObject for the node.
+  void
+  createNodeGraphicsObject(NodeId const nodeId);
+
+  void
+  createConnectionGraphicsObject(ConnectionId const connectionId);
+
+  /// Adds the connection to the layer or creates its graphics object.
+  void
+  materializeConnection(ConnectionId const connectionId);
+
+  bool
+  isConnectionMaterialized(ConnectionId const connectionId) const;
+
+  void
+  scheduleConnectionDemotion();
+
+  /// Brings the spatial indices up to date before a query.
+  void
+  updateSpatialIndex();
+
+  /// Node bounds guessed from the model for nodes without objects.
+  QRectF
+  estimatedNodeRect(NodeId const nodeId) const;
+
+  /// Updates the model position index of the node and its connections.
+  void
+  indexModelNode(NodeId const nodeId, QRectF const & rect);
+
+  void
+  indexModelConnection(ConnectionId const connectionId);
+
+  /// `true` for items which must not be released by the virtualization.
+  bool
+  isPinned(QGraphicsItem * item) const;
+
+  void
+  scheduleVirtualizationUpdate();
+
+  void
+  scheduleSelectionFlush();
+
+  void
+  scheduleStatusFlush();
+
 private Q_SLOTS:
 
 
@@ -195,6 +540,14 @@ private Q_SLOTS:
   void
   onNodeResized(NodeId const nodeId);
 
+  /// Refreshes the geometry of the node after a change of its state.
+  void
+  onNodeUpdated(NodeId const nodeId);
+
+  /// Drops the parsed style of the node and repaints it.
+  void
+  onNodeStyleChanged(NodeId const nodeId);
+
   void
   onNodeCreated(NodeId const nodeId);
 
@@ -221,6 +574,36 @@ private Q_SLOTS:
                   PortType const portType,
                   std::unordered_set<PortIndex> const &portIndexSet);
 
+  void
+  enforceUndoMemoryBudget();
+
+  void
+  onBatchUpdateStarted();
+
+  /// Creates the graphics objects deferred during the batch in one pass.
+  void
+  onBatchUpdateFinished();
+
+  /// Creates and releases graphics objects around the visible area.
+  void
+  updateVirtualization();
+
+  /// Moves the released connection objects back to the layer.
+  void
+  demoteConnections();
+
+  /// Creates graphics objects for the pending nodes within the budget.
+  void
+  populateChunk();
+
+  /// Emits `selectionSetChanged` with the accumulated changes.
+  void
+  flushSelectionChanges();
+
+  /// Repaints the items changed by `updateNodeStatuses` and the heatmap.
+  void
+  flushStatusUpdates();
+
 private:
 
   // TODO shared pointer?
@@ -244,6 +627,89 @@ private:
   std::unique_ptr<ConnectionGraphicsObject> _draftConnection;
 
   QUndoStack* _undoStack;
+
+  bool _translatingNodes;
+
+  int _nodeDragGesture;
+
+  qint64 _undoMemoryBudget;
+
+  int _batchDepth;
+
+  std::vector<NodeId> _batchNodes;
+
+  std::vector<ConnectionId> _batchConnections;
+
+  /// Nodes to repaint when the batch finishes.
+  std::unordered_set<NodeId> _batchTouchedNodes;
+
+  std::unique_ptr<SpatialIndex<NodeId>> _nodeIndex;
+
+  std::unique_ptr<SpatialIndex<ConnectionId>> _connectionIndex;
+
+  /// Items moved or resized since the last query.
+  std::unordered_set<NodeId> _dirtyNodeBounds;
+
+  std::unordered_set<ConnectionId> _dirtyConnectionBounds;
+
+  bool _virtualized;
+
+  qreal _virtualizationMargin;
+
+  QRectF _visibleRect;
+
+  bool _virtualizationScheduled;
+
+  /// Model positions of all the items, used by the virtualized mode.
+  std::unique_ptr<SpatialIndex<NodeId>> _modelNodeIndex;
+
+  std::unique_ptr<SpatialIndex<ConnectionId>> _modelConnectionIndex;
+
+  std::unique_ptr<NodePixmapCache> _nodePixmapCache;
+
+  std::unique_ptr<ConnectionLayer> _connectionLayer;
+
+  bool _demotionScheduled;
+
+  QTimer * _populationTimer;
+
+  /// Nodes left to the incremental population, the next one is last.
+  std::vector<NodeId> _pendingNodes;
+
+  int _populationTotal;
+
+  int _populationBudget;
+
+  bool _populationOrderDirty;
+
+  std::unordered_set<NodeId> _selectedNodes;
+
+  std::unordered_set<ConnectionId> _selectedConnections;
+
+  /// Selection state before the first change since the last emission.
+  std::unordered_map<NodeId, bool> _nodeSelectionBefore;
+
+  std::unordered_map<ConnectionId, bool> _connectionSelectionBefore;
+
+  bool _selectionFlushScheduled;
+
+  std::vector<NodeStyle> _statusStyles;
+
+  /// Kept by the scene, the graphics objects may be recreated.
+  std::unordered_map<NodeId, int> _nodeStatuses;
+
+  std::unordered_set<NodeId> _lockedNodes;
+
+  /// Styles parsed for the models without NodeRole::StyleIndex.
+  mutable std::unordered_map<NodeId, ParsedNodeStyle> _parsedNodeStyles;
+
+  std::unordered_set<NodeId> _statusDirtyNodes;
+
+  std::unordered_set<ConnectionId> _statusDirtyConnections;
+
+  bool _statusFlushScheduled;
+
+  NodeHeatmap const * _heatmap;
 };
 
 
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Export.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+
+
+namespace QtNodes
+{
+
+/// Container codecs for saved graphs.
+enum class GraphCompression
+{
+  None, ///< Plain JSON.
+  Zlib, ///< JSON in zlib-compressed blocks, see CompressedDevice.
+};
+
+
+/// Sequential device (de)compressing a graph stream block by block.
+/**
+ * The compressed container starts with the "QNZ1" magic and a codec
+ * byte, followed by blocks of `[quint32 big-endian size][qCompress
+ * data]` and a zero-sized terminating block. The device never holds
+ * more than one uncompressed and one compressed block, so the streams
+ * of any size are processed in bounded memory.
+ *
+ * The underlying device must stay open while the CompressedDevice is
+ * used. For writing, `close()` must be called (the destructor does it)
+ * to flush the last block.
+ */
+class NODE_EDITOR_PUBLIC CompressedDevice : public QIODevice
+{
+public:
+  CompressedDevice(QIODevice & device,
+                   GraphCompression compression = GraphCompression::Zlib);
+
+  ~CompressedDevice() override;
+
+  /// Peeks the header without consuming any input.
+  static
+  bool
+  isCompressed(QIODevice & device);
+
+  /// Size of the uncompressed blocks produced when writing.
+  void
+  setBlockSize(int blockSize);
+
+  /// `ReadOnly` or `WriteOnly` only.
+  bool
+  open(OpenMode mode) override;
+
+  void
+  close() override;
+
+  bool
+  isSequential() const override { return true; }
+
+  qint64
+  bytesAvailable() const override;
+
+  /// `true` after a failed write, a truncated or corrupted input.
+  bool
+  hasError() const { return _error; }
+
+protected:
+  qint64
+  readData(char * data, qint64 maxSize) override;
+
+  qint64
+  writeData(char const * data, qint64 maxSize) override;
+
+private:
+  bool
+  writeBlock();
+
+  bool
+  readBlock();
+
+private:
+  QIODevice & _device;
+
+  GraphCompression _compression;
+
+  int _blockSize;
+
+  QByteArray _block;
+
+  int _blockPos;
+
+  bool _finished;
+
+  bool _error;
+};
+
+}
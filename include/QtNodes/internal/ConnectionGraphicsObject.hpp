@@ -62,6 +62,13 @@ public:
   std::pair<QPointF, QPointF>
   pointsC1C2() const;
 
+  /// Control points of the cubic connecting `out` to `in`.
+  static
+  std::pair<QPointF, QPointF>
+  pointsC1C2(QPointF const & out,
+             QPointF const & in,
+             PortLayout const layout);
+
   void
   setEndPoint(PortType portType, QPointF const &point);
 
@@ -80,8 +87,18 @@ public:
   ConnectionStyle
   connectionStyle() const;
 
+  /// Style of `connectionId`, also used for connections drawn without
+  /// their own graphics object.
+  static
+  ConnectionStyle
+  connectionStyle(BasicGraphicsScene const & scene,
+                  ConnectionId const &       connectionId);
+
 protected:
 
+  QVariant
+  itemChange(GraphicsItemChange change, const QVariant &value) override;
+
   void
   paint(QPainter * painter,
         QStyleOptionGraphicsItem const * option,
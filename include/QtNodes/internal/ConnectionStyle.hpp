@@ -33,6 +33,7 @@ public:
   QColor constructionColor() const;
   QColor normalColor() const;
   QColor normalColor(QString typeId) const;
+  void setNormalColor(QColor const & color);
   QColor selectedColor() const;
   QColor selectedHaloColor() const;
   QColor hoveredColor() const;
@@ -43,6 +44,12 @@ public:
 
   bool useDataDefinedColors() const;
 
+  /// Below this zoom level connections are drawn as straight lines.
+  float lowDetailScale() const;
+
+  /// Below this zoom level the halo and the end points are omitted.
+  float mediumDetailScale() const;
+
 private:
 
   QColor ConstructionColor;
@@ -56,5 +63,8 @@ private:
   float PointDiameter;
 
   bool UseDataDefinedColors;
+
+  float LowDetailScale;
+  float MediumDetailScale;
 };
 }
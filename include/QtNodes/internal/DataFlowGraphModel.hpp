@@ -1,15 +1,20 @@
 #pragma once
 
+#include "CompressedDevice.hpp"
 #include "ConnectionIdUtils.hpp"
+#include "GraphStreamReader.hpp"
 #include "NodeDelegateModelRegistry.hpp"
 #include "Export.hpp"
 #include "AbstractGraphModel.hpp"
 #include "StyleCollection.hpp"
 
+#include <QJsonDocument>
 #include <QJsonObject>
 
 #include <memory>
 
+class QIODevice;
+
 namespace QtNodes
 {
 
@@ -30,6 +35,41 @@ public:
   std::shared_ptr<NodeDelegateModelRegistry>
   dataModelRegistry() { return _registry; }
 
+  /// Defers the instantiation of delegate models for loaded nodes.
+  /**
+   * In the lazy mode `loadNode` registers lightweight placeholders
+   * which keep only the node's internal data. Captions, port counts
+   * and data types are answered by a shared prototype of the node's
+   * type. The real delegate model is created when the node receives
+   * data, its delegate model is fetched with `delegateModel` or
+   * `materializeNode` is called, DataFlowGraphicsScene does so for the
+   * nodes the user selects. Placeholders have no embedded widget, it
+   * is embedded on the `nodeUpdated` which follows the materialization.
+   * Materializing a node materializes its upstream nodes as well, so
+   * that the node can compute.
+   *
+   * Models opt out with `NodeDelegateModel::allowsDeferredLoad`.
+   * Disabling the mode materializes all the remaining placeholders.
+   */
+  void
+  setLazyLoading(bool lazy);
+
+  bool
+  lazyLoading() const { return _lazyLoading; }
+
+  /// @returns `false` for nodes which are still placeholders.
+  bool
+  isMaterialized(NodeId const nodeId) const;
+
+  /// Replaces the placeholder of the node, and of its upstream nodes,
+  /// with the real delegate model.
+  /**
+   * @returns `false` when the node does not exist or its model could
+   * not be created.
+   */
+  bool
+  materializeNode(NodeId const nodeId);
+
 public:
   std::unordered_set<NodeId>
   allNodeIds() const override;
@@ -94,12 +134,95 @@ public:
   QJsonDocument
   save() const;
 
+  /// Writes the graph as JSON to the `device`, indented by default.
+  /**
+   * Serialized node records are cached, so only the nodes marked dirty
+   * since the previous save are passed through `saveNode` again; the
+   * rest are spliced in from the cache. Nodes are written first and
+   * ordered by id.
+   *
+   * Dirty nodes whose models return `true` from
+   * `NodeDelegateModel::saveIsThreadSafe` are serialized concurrently;
+   * the output is byte-identical to the sequential one.
+   *
+   * With a `compression` other than `None` the JSON is streamed through
+   * a CompressedDevice. Changing the `format` between saves serializes
+   * every node again.
+   */
+  bool
+  save(QIODevice &               device,
+       GraphCompression          compression = GraphCompression::None,
+       QJsonDocument::JsonFormat format = QJsonDocument::Indented) const;
+
+  /// Drops the cached record of the node.
+  /**
+   * Position changes, `NodeDelegateModel::dataUpdated`,
+   * `NodeDelegateModel::internalDataChanged` and loading mark nodes
+   * dirty automatically. Call the function when the internal state of
+   * a model changed without any of those.
+   */
+  void
+  markNodeDirty(NodeId const nodeId);
+
   void
   loadNode(QJsonObject const & nodeJson) override;
 
+  /**
+   * Creates the delegate models on the calling thread, runs
+   * `NodeDelegateModel::prepareLoad` for all of them on the global
+   * thread pool and then registers the nodes one by one in the input order.
+   */
+  void
+  loadNodes(std::vector<QJsonObject> const & nodesJson) override;
+
   void
   load(QJsonDocument const &json);
 
+  /// Streams the graph from the `device`, plain or compressed.
+  /**
+   * `progress` receives the position of the `device` and its size,
+   * compressed input included. A sequential device reports the bytes
+   * read so far and -1 for the size.
+   *
+   * @returns `false` with an `errorString()` on a failure.
+   */
+  bool
+  load(QIODevice &                         device,
+       GraphStreamReader::ProgressCallback progress = {});
+
+  QString
+  errorString() const { return _errorString; }
+
+  /// Applies the differences between the model and `json`.
+  /**
+   * Nodes are matched by id. A node of the same type keeps its delegate
+   * model, and therefore its graphics object, only moving or reloading
+   * its internal data when they differ. Nodes whose type or number of
+   * ports changed are recreated. Only the nodes and connections absent
+   * from `json` are deleted and only the missing ones are created.
+   * Data is propagated once everything is in place, as in
+   * `loadSubgraph`.
+   */
+  void
+  reconcile(QJsonDocument const & json);
+
+  /**
+   * Data is not propagated while the subgraph is being restored. Once
+   * all the nodes and connections are in place, every out port feeding
+   * a restored connection propagates its data once.
+   */
+  void
+  loadSubgraph(std::vector<QJsonObject> const &  nodesJson,
+               std::vector<ConnectionId> const & connectionIds) override;
+
+  /**
+   * Only the surviving nodes which lost an input get empty data, once
+   * per port.
+   */
+  void
+  deleteSubgraph(std::vector<NodeId> const &       nodeIds,
+                 std::vector<ConnectionId> const & connectionIds) override;
+
   QJsonObject
   saveConnection(ConnectionId const & connId) const override;
 
@@ -114,11 +237,7 @@ public:
   NodeDelegateModelType*
   delegateModel(NodeId const nodeId)
   {
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
-      return nullptr;
-
-    auto model = dynamic_cast<NodeDelegateModelType*>(it->second.get());
+    auto model = dynamic_cast<NodeDelegateModelType*>(materialize(nodeId));
 
     return model;
   }
@@ -127,6 +246,10 @@ private:
   NodeId
   newNodeId() { return _nextNodeId++; }
 
+  /// Forwards the output and internal data updates of the delegate model.
+  void
+  connectDelegateModel(NodeId const nodeId, NodeDelegateModel * model);
+
   /**
    * The function could be used when we restore nodes from some file
    * and the NodeId values are already known.  In this case we must
@@ -139,6 +262,49 @@ private:
     _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
   }
 
+  /**
+   * Registers the already created `model` under the id stored in
+   * `nodeJson` and restores its position. The internal data is loaded
+   * only when `loadInternalData` is `true`.
+   */
+  void
+  restoreNode(QJsonObject const &                nodeJson,
+              std::unique_ptr<NodeDelegateModel> model,
+              bool                               loadInternalData);
+
+  /// Serializes the dirty nodes whose models allow it on a thread
+  /// pool and stores the records in the cache.
+  void
+  serializeDirtyNodes(std::vector<NodeId> const & nodeIds) const;
+
+  /// The cached JSON of `saveNode`, refreshed if dirty.
+  QByteArray const &
+  nodeRecord(NodeId const nodeId) const;
+
+  /// Registers a placeholder for a node which is restored lazily.
+  void
+  restorePlaceholder(QJsonObject const & nodeJson);
+
+  /// @returns `true` if nodes of the type may be restored lazily.
+  bool
+  deferrable(QString const & modelName) const;
+
+  /// A shared model instance answering queries for placeholders.
+  NodeDelegateModel const *
+  prototype(QString const & modelName) const;
+
+  /// The delegate model or, for placeholders, the type's prototype.
+  NodeDelegateModel const *
+  descriptor(NodeId const nodeId) const;
+
+  /// Replaces the placeholder with the real delegate model.
+  NodeDelegateModel *
+  materialize(NodeId const nodeId);
+
+  /// Creates and loads the model of one placeholder, no data is pulled.
+  bool
+  createMaterializedModel(NodeId const nodeId);
+
 private Q_SLOTS:
   /**
    * Fuction is called in three cases:
@@ -165,10 +331,27 @@ private:
 
   NodeId _nextNodeId;
 
+  bool _lazyLoading;
+
+  /// Set while a subgraph is restored or deleted.
+  bool _propagationSuspended;
+
+  /// Placeholders are stored as null pointers.
   std::unordered_map<NodeId,
                      std::unique_ptr<NodeDelegateModel>>
   _models;
 
+  struct LazyNode
+  {
+    QString modelName;
+    QJsonObject internalData;
+  };
+
+  std::unordered_map<NodeId, LazyNode> _lazyNodes;
+
+  mutable std::unordered_map<QString, std::unique_ptr<NodeDelegateModel>>
+  _prototypes;
+
   using ConnectivityKey =
     std::tuple<NodeId, PortType, PortIndex>;
 
@@ -178,6 +361,14 @@ private:
 
   mutable std::unordered_map<NodeId, NodeGeometryData>
   _nodeGeometryData;
+
+  /// JSON records of the clean nodes, in `_nodeRecordsFormat`.
+  mutable std::unordered_map<NodeId, QByteArray>
+  _nodeRecords;
+
+  mutable QJsonDocument::JsonFormat _nodeRecordsFormat;
+
+  QString _errorString;
 };
 
 
@@ -21,7 +21,8 @@ class NODE_EDITOR_PUBLIC DataFlowGraphicsScene
 public:
 
   DataFlowGraphicsScene(DataFlowGraphModel &graphModel,
-                        QObject * parent = nullptr);
+                        QObject * parent = nullptr,
+                        PopulationMode populationMode = PopulationMode::Immediate);
 
   ~DataFlowGraphicsScene() = default;
 
@@ -29,6 +30,13 @@ public:
   QMenu *
   createSceneMenu(QPointF const scenePos) override;
 
+  /// Container used by `save()`. `load()` detects it automatically.
+  void
+  setCompression(GraphCompression compression) { _compression = compression; }
+
+  GraphCompression
+  compression() const { return _compression; }
+
 
 public Q_SLOTS:
   void
@@ -47,8 +55,27 @@ public Q_SLOTS:
 
   void loadFromJsonDocument(QJsonDocument const& json);
 
+  /// Unlike `loadFromJsonDocument`, keeps the unchanged nodes of the scene.
+  /**
+   * See `DataFlowGraphModel::reconcile`. Meant for graphs reloaded
+   * repeatedly, the graphics objects and embedded widgets of the nodes
+   * present in both versions survive.
+   */
+  void reconcileWithJsonDocument(QJsonDocument const& json);
+
+Q_SIGNALS:
+  /// Emitted while `load()` streams the file into the model.
+  /**
+   * The counters refer to the file, compressed or not. `bytesTotal` is
+   * `-1` when the size of the input is not known.
+   */
+  void
+  loadProgress(qint64 bytesProcessed, qint64 bytesTotal);
+
 private:
   DataFlowGraphModel &_graphModel;
+
+  GraphCompression _compression;
 };
 
 }
@@ -30,6 +30,7 @@ enum class NodeRole
   NumberOfInPorts  = 7, ///< `unsigned int`
   NumberOfOutPorts = 9, ///< `unsigned int`
   Widget           = 10, ///< Optional `QWidget*` or `nullptr`
+  StyleIndex       = 11, ///< `int` handle from `StyleCollection::registerNodeStyle`
 };
 Q_ENUM_NS(NodeRole)
 
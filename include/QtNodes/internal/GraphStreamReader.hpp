@@ -0,0 +1,131 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+
+#include "Export.hpp"
+
+class QIODevice;
+
+namespace QtNodes
+{
+
+class AbstractGraphModel;
+
+/// Incremental reader for `.flow` files.
+/**
+ * The reader consumes the device in fixed-size chunks and extracts the
+ * records of the top-level `nodes` and `connections` arrays one by one.
+ * Node records are collected into small batches for
+ * `AbstractGraphModel::loadNodes`, connection records are handed to
+ * `AbstractGraphModel::loadConnection` as soon as they are complete,
+ * so neither the whole file nor the whole QJsonDocument is ever held
+ * in memory. Peak memory is bounded by the chunk size plus one batch
+ * of node records.
+ *
+ * Connection records which precede the `nodes` array are deferred
+ * until all the nodes are restored.
+ */
+class NODE_EDITOR_PUBLIC GraphStreamReader
+{
+public:
+  /// Called after each consumed chunk with the byte counters.
+  using ProgressCallback =
+    std::function<void (qint64 bytesProcessed, qint64 bytesTotal)>;
+
+public:
+  GraphStreamReader(AbstractGraphModel &graphModel);
+
+  void
+  setProgressCallback(ProgressCallback callback);
+
+  void
+  setChunkSize(qint64 chunkSize);
+
+  /// Number of node records handed to `AbstractGraphModel::loadNodes`
+  /// at once.
+  void
+  setBatchSize(std::size_t batchSize);
+
+  /// Reads the whole device. The device must be open for reading.
+  /**
+   * @returns `false` if the input is not a well-formed graph file.
+   * Records restored before the error are kept in the model.
+   */
+  bool
+  read(QIODevice &device);
+
+  QString
+  errorString() const { return _errorString; }
+
+  std::size_t
+  nodeCount() const { return _nodeCount; }
+
+  std::size_t
+  connectionCount() const { return _connectionCount; }
+
+private:
+  enum class Section
+  {
+    None,
+    Nodes,
+    Connections,
+    Skipped
+  };
+
+  void
+  reset();
+
+  bool
+  consume(char const * data, qint64 size);
+
+  bool
+  finishRecord();
+
+  void
+  applyConnection(QJsonObject const & connJson);
+
+  void
+  flushNodeBatch();
+
+private:
+  AbstractGraphModel &_graphModel;
+
+  ProgressCallback _progressCallback;
+
+  qint64 _chunkSize;
+
+  std::size_t _batchSize;
+
+  QString _errorString;
+
+  std::size_t _nodeCount;
+
+  std::size_t _connectionCount;
+
+  // Tokenizer state.
+
+  int _depth;
+
+  bool _inString;
+
+  bool _escaped;
+
+  bool _nodesDone;
+
+  Section _section;
+
+  QByteArray _lastKey;
+
+  QByteArray _record;
+
+  std::vector<QJsonObject> _nodeBatch;
+
+  std::vector<QJsonObject> _deferredConnections;
+};
+
+}
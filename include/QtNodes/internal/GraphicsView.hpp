@@ -4,6 +4,8 @@
 
 #include "Export.hpp"
 
+class QRubberBand;
+
 namespace QtNodes
 {
 
@@ -62,20 +64,38 @@ protected:
   void
   mouseMoveEvent(QMouseEvent *event) override;
 
+  void
+  mouseReleaseEvent(QMouseEvent *event) override;
+
   void
   drawBackground(QPainter* painter, const QRectF & r) override;
 
   void
   showEvent(QShowEvent *event) override;
 
+  void
+  resizeEvent(QResizeEvent *event) override;
+
+  void
+  scrollContentsBy(int dx, int dy) override;
+
 protected:
   BasicGraphicsScene *
   nodeScene();
 
+  /// Passes the visible part of the scene to the scene's virtualization.
+  void
+  reportVisibleRect();
+
 private:
   QAction* _clearSelectionAction;
   QAction* _deleteSelectionAction;
 
   QPointF _clickPos;
+
+  /// Shift-drag selection, created on first use.
+  QRubberBand* _rubberBand;
+
+  QPoint _rubberBandOrigin;
 };
 }
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "AbstractGraphModel.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QPointF>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+
+#include <unordered_map>
+
+
+namespace QtNodes
+{
+
+/// Read-only graph model backed by a memory-mapped binary file.
+/**
+ * The file consists of a fixed-size header, a fixed-width node table
+ * sorted by NodeId, a connection table in CSR order (sorted by the
+ * out-node), an index of the connection table sorted by the in-node
+ * and a pool with strings and serialized internal data. All the
+ * queries read directly from the mapping, so opening the file takes
+ * constant time and resident memory grows only with the pages the
+ * view actually touches. Record ranges are checked as they are read, a
+ * corrupt file yields missing data rather than reads outside of the
+ * mapping.
+ *
+ * Graph structure can't be modified. Node positions and sizes set by
+ * the scene are kept in a small in-memory overlay.
+ *
+ * The file is written by `MappedGraphModel::write` from any other
+ * AbstractGraphModel and uses the native byte order.
+ */
+class NODE_EDITOR_PUBLIC MappedGraphModel : public AbstractGraphModel
+{
+  Q_OBJECT
+
+public:
+  MappedGraphModel();
+
+  ~MappedGraphModel() override;
+
+  /// Maps the file. Previously opened file is closed.
+  bool
+  open(QString const & fileName);
+
+  void
+  close();
+
+  bool
+  isOpen() const { return _data != nullptr; }
+
+  QString
+  errorString() const { return _errorString; }
+
+  /// Serializes `graphModel` into the memory-mappable format.
+  static
+  bool
+  write(AbstractGraphModel const & graphModel,
+        QString const & fileName);
+
+public:
+  std::unordered_set<NodeId>
+  allNodeIds() const override;
+
+  std::unordered_set<ConnectionId>
+  allConnectionIds(NodeId const nodeId) const override;
+
+  std::unordered_set<ConnectionId>
+  connections(NodeId    nodeId,
+              PortType  portType,
+              PortIndex portIndex) const override;
+
+  bool
+  connectionExists(ConnectionId const connectionId) const override;
+
+  NodeId
+  addNode(QString const nodeType = QString()) override;
+
+  bool
+  connectionPossible(ConnectionId const connectionId) const override;
+
+  void
+  addConnection(ConnectionId const connectionId) override;
+
+  bool
+  nodeExists(NodeId const nodeId) const override;
+
+  QVariant
+  nodeData(NodeId nodeId, NodeRole role) const override;
+
+  NodeFlags
+  nodeFlags(NodeId nodeId) const override;
+
+  bool
+  setNodeData(NodeId   nodeId,
+              NodeRole role,
+              QVariant value) override;
+
+  QVariant
+  portData(NodeId    nodeId,
+           PortType  portType,
+           PortIndex portIndex,
+           PortRole  role) const override;
+
+  bool
+  setPortData(NodeId          nodeId,
+              PortType        portType,
+              PortIndex       portIndex,
+              QVariant const& value,
+              PortRole        role = PortRole::Data) override;
+
+  bool
+  deleteConnection(ConnectionId const connectionId) override;
+
+  bool
+  deleteNode(NodeId const nodeId) override;
+
+  QJsonObject
+  saveNode(NodeId const nodeId) const override;
+
+  QJsonObject
+  saveConnection(ConnectionId const & connId) const override;
+
+  void
+  loadConnection(QJsonObject const & connJson) override;
+
+private:
+  struct FileHeader;
+  struct NodeRecord;
+  struct ConnectionRecord;
+  struct PoolRef;
+
+  NodeRecord const *
+  findNode(NodeId const nodeId) const;
+
+  NodeRecord const *
+  nodeTable() const;
+
+  ConnectionRecord const *
+  connectionTable() const;
+
+  quint32 const *
+  inConnectionIndex() const;
+
+  QByteArray
+  poolBytes(PoolRef const & ref) const;
+
+  QString
+  poolString(PoolRef const & ref) const;
+
+  QVariant
+  portEntry(NodeRecord const & node,
+            PortType           portType,
+            PortIndex          portIndex,
+            PortRole           role) const;
+
+private:
+  QFile _file;
+
+  uchar const * _data;
+
+  qint64 _size;
+
+  FileHeader const * _header;
+
+  QString _errorString;
+
+  std::unordered_map<NodeId, QPointF> _positions;
+
+  std::unordered_map<NodeId, QSize> _sizes;
+};
+
+}
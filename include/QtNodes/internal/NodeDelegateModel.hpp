@@ -67,6 +67,42 @@ public:
   void
   load(QJsonObject const &) override;
 
+  /// Restores the internal data off the GUI thread.
+  /**
+   * Called from a worker thread by `DataFlowGraphModel::loadNodes`
+   * before the model is registered in the graph. Reimplement it to
+   * decode heavy payloads (images, tables, scripts) concurrently with
+   * other nodes. The function must not touch widgets, emit signals or
+   * access shared state without synchronization.
+   *
+   * @returns `true` if the state is fully restored, `load()` is then
+   * not called. The default implementation returns `false`.
+   */
+  virtual
+  bool
+  prepareLoad(QJsonObject const &) { return false; }
+
+  /// Whether `DataFlowGraphModel` may restore the node as a placeholder.
+  /**
+   * Return `false` if captions, ports or data types depend on the
+   * loaded internal data, or if loading has side effects which must
+   * happen immediately.
+   */
+  virtual
+  bool
+  allowsDeferredLoad() const { return true; }
+
+  /// Whether `save()` may be called from a worker thread.
+  /**
+   * Return `true` if `save()` only reads state which is not modified
+   * concurrently while the graph is being saved. Then
+   * `DataFlowGraphModel::save(QIODevice&)` serializes the node on a
+   * thread pool together with the others.
+   */
+  virtual
+  bool
+  saveIsThreadSafe() const { return false; }
+
 public:
 
   virtual
@@ -86,9 +122,18 @@ public:
   NodeStyle const&
   nodeStyle() const;
 
+  /// Registers `style` in the StyleCollection palette and uses it.
+  /**
+   * Registered styles are never freed, keep a few styles and switch
+   * between them rather than setting a new one on every update.
+   */
   void
   setNodeStyle(NodeStyle const& style);
 
+  /// Palette handle of the style, 0 for the global node style.
+  int
+  nodeStyleHandle() const;
+
 public:
 
   virtual
@@ -150,6 +195,19 @@ Q_SIGNALS:
   void
   dataInvalidated(PortIndex const index);
 
+  /// The state written by `save()` changed.
+  /**
+   * Emit it on every edit of the internal data, e.g. from the embedded
+   * widget. The graph model then refreshes the saved record of the node
+   * and the autosave journal records the new state.
+   */
+  void
+  internalDataChanged();
+
+  /// Emitted by `setNodeStyle`.
+  void
+  nodeStyleChanged();
+
   void
   computingStarted();
 
@@ -161,6 +219,8 @@ Q_SIGNALS:
 
 private:
   NodeStyle _nodeStyle;
+
+  int _nodeStyleHandle = 0;
 };
 
 
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QUuid>
 #include <QtWidgets/QGraphicsObject>
 
 #include "NodeState.hpp"
 
+#include <memory>
+
 class QGraphicsProxyWidget;
 
 namespace QtNodes
@@ -12,6 +15,7 @@ namespace QtNodes
 
 class BasicGraphicsScene;
 class AbstractGraphModel;
+class NodeTextCache;
 
 class NodeGraphicsObject : public QGraphicsObject
 {
@@ -27,7 +31,7 @@ public:
   NodeGraphicsObject(BasicGraphicsScene &scene,
                      NodeId node);
 
-  ~NodeGraphicsObject() override = default;
+  ~NodeGraphicsObject() override;
 
 public:
 
@@ -49,6 +53,27 @@ public:
   NodeState const &
   nodeState() const { return _nodeState; }
 
+  /// Order of addition to the scene.
+  /**
+   * The nodes are top-level items, so among equal z values Qt stacks
+   * the ones added later on top.
+   */
+  quint64
+  stackingOrder() const { return _stackingOrder; }
+
+  /// Laid out caption and port labels, reused by every paint.
+  NodeTextCache &
+  textCache() { return *_textCache; }
+
+  /// Pixmap cache key part filled by `NodePainter::contentKey`.
+  QByteArray &
+  contentKey() { return _contentKey; }
+
+  /// Called by the scene when the caption, style, ports or connections
+  /// of the node change.
+  void
+  invalidateContentKey() { _contentKey.clear(); }
+
   QRectF
   boundingRect() const override;
 
@@ -69,6 +94,22 @@ public:
 
   void lock(bool locked);
 
+  /// Takes the embedded widget out of the node without deleting it.
+  /**
+   * Used when the scene releases the object while the node stays in
+   * the model, the delegate model keeps owning its widget.
+   */
+  void
+  detachEmbeddedWidget();
+
+  /// Embeds the widget of the model, if any and not embedded yet.
+  /**
+   * Called on construction and again on `nodeUpdated`, the widget of
+   * a lazily loaded node appears once its model is materialized.
+   */
+  void
+  embedQWidget();
+
 protected:
   void
   paint(QPainter* painter,
@@ -102,10 +143,6 @@ protected:
   void
   contextMenuEvent(QGraphicsSceneContextMenuEvent* event) override;
 
-private:
-  void
-  embedQWidget();
-
 protected:
   NodeId _nodeId;
 
@@ -115,6 +152,12 @@ protected:
 
   // either nullptr or owned by parent QGraphicsItem
   QGraphicsProxyWidget * _proxyWidget;
+
+  std::unique_ptr<NodeTextCache> _textCache;
+
+  QByteArray _contentKey;
+
+  quint64 const _stackingOrder;
 };
 
 class RootNodeObject : public NodeGraphicsObject
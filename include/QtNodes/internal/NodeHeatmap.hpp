@@ -0,0 +1,182 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtGui/QColor>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+class BasicGraphicsScene;
+
+/// Colors the nodes by how often or how long they ran.
+/**
+ * Executions are counted in a fixed-size array indexed by the node id,
+ * so that `recordExecution()` is a few relaxed atomic operations and
+ * can be called from any thread. Ids at or above the capacity are not
+ * counted.
+ *
+ * While shown, the heatmap maps the selected metric of every node to
+ * one of `LevelCount` precomputed colors once per frame, relative to
+ * the highest value, and repaints only the nodes whose level changed.
+ * Nodes which never ran keep their own look. Optionally the
+ * connections take the color of the node they enter.
+ *
+ * A hidden heatmap costs the painters a single pointer check.
+ */
+class NODE_EDITOR_PUBLIC NodeHeatmap : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum class Metric
+  {
+    ExecutionCount, ///< Number of recorded executions.
+    CumulativeTime, ///< Sum of the execution times.
+    LastLatency,    ///< Duration of the latest execution.
+  };
+  Q_ENUM(Metric)
+
+  /// Number of distinct colors, from cold to hot.
+  static constexpr int LevelCount = 64;
+
+  NodeHeatmap(BasicGraphicsScene & scene,
+              NodeId capacity = 65536,
+              QObject * parent = nullptr);
+
+  ~NodeHeatmap() override;
+
+public:
+  /// Thread-safe. Counts one execution lasting `nsecs` nanoseconds.
+  /**
+   * @returns `false` when `nodeId` is outside of the capacity.
+   */
+  bool
+  recordExecution(NodeId const nodeId, qint64 nsecs);
+
+  /// Thread-safe. Zeroes the counters of all the nodes.
+  void
+  reset();
+
+  quint64
+  executionCount(NodeId const nodeId) const;
+
+  /// Nanoseconds.
+  qint64
+  cumulativeTime(NodeId const nodeId) const;
+
+  /// Nanoseconds.
+  qint64
+  lastLatency(NodeId const nodeId) const;
+
+  NodeId
+  capacity() const { return _capacity; }
+
+public:
+  /// ExecutionCount by default.
+  void
+  setMetric(Metric metric);
+
+  Metric
+  metric() const { return _metric; }
+
+  /// Colors of the lowest and of the highest level, interpolated in between.
+  /**
+   * The alpha channel decides how much of the node style shows through.
+   */
+  void
+  setGradient(QColor const & cold, QColor const & hot);
+
+  /// Whether the connections are colored as well, `false` by default.
+  void
+  setColoringConnections(bool coloring);
+
+  bool
+  coloringConnections() const { return _coloringConnections; }
+
+  /// 16 ms by default.
+  void
+  setFrameInterval(int msec);
+
+  /// Attaches the heatmap to the scene and starts the frame updates.
+  void
+  show();
+
+  /// Detaches the heatmap, the nodes get back their own look.
+  void
+  hide();
+
+  bool
+  isShown() const { return _shown; }
+
+public:
+  /// Level in [0, LevelCount) as of the last frame, -1 for nodes which never ran.
+  int
+  level(NodeId const nodeId) const;
+
+  /// Color of the level, invalid for nodes which never ran.
+  QColor
+  color(NodeId const nodeId) const;
+
+public Q_SLOTS:
+  /// Recomputes the levels now and repaints the changed nodes.
+  void
+  refresh();
+
+private:
+  struct Counters
+  {
+    std::atomic<quint64> count{0};
+
+    std::atomic<qint64> totalTime{0};
+
+    std::atomic<qint64> lastLatency{0};
+  };
+
+  qint64
+  metricValue(Counters const & counters) const;
+
+  /// Nodes drawn with a heat color.
+  std::vector<NodeId>
+  levelledNodes() const;
+
+  /// Forces the next `refresh()` to reconsider every node.
+  void
+  invalidate();
+
+private:
+  BasicGraphicsScene & _scene;
+
+  NodeId const _capacity;
+
+  std::unique_ptr<Counters[]> _counters;
+
+  /// One past the highest id recorded, bounds the per-frame scan.
+  std::atomic<NodeId> _end;
+
+  /// Set by the producers, cleared by `refresh()`.
+  std::atomic<bool> _changed;
+
+  /// Indexed by the node id, written by the GUI thread only.
+  std::vector<qint8> _levels;
+
+  std::vector<QColor> _colors;
+
+  Metric _metric;
+
+  bool _coloringConnections;
+
+  bool _shown;
+
+  QTimer _frameTimer;
+};
+
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+class BasicGraphicsScene;
+class NodeStatusQueue;
+
+/// One status transition reported by a monitored application.
+struct NodeStatusRecord
+{
+  /// Milliseconds since the epoch.
+  qint64 timestamp;
+
+  NodeId nodeId;
+
+  /// Index into the styles of `BasicGraphicsScene::setStatusStyles`.
+  int status;
+};
+
+/// Feeds node statuses received on any thread into the scene.
+/**
+ * Producer threads `push()` status records into a bounded lock-free
+ * queue. Once per frame the GUI thread drains the queue, keeps the
+ * latest status of every node and applies the result with a single
+ * `BasicGraphicsScene::updateNodeStatuses` call, so a burst of
+ * thousands of transitions costs one repaint of the changed items.
+ *
+ * When the queue is full new records are dropped rather than blocking
+ * the producers; `droppedCount()` reports them and `lastLag()` tells
+ * how long the oldest applied record waited.
+ */
+class NODE_EDITOR_PUBLIC NodeStatusIngestor : public QObject
+{
+  Q_OBJECT
+
+public:
+  NodeStatusIngestor(BasicGraphicsScene & scene,
+                     std::size_t capacity = 65536,
+                     QObject * parent = nullptr);
+
+  ~NodeStatusIngestor() override;
+
+public:
+  /// Thread-safe. @returns `false` when the record was dropped.
+  bool
+  push(NodeId const nodeId, int status, qint64 timestamp);
+
+  /// Thread-safe, stamps the record with the current time.
+  bool
+  push(NodeId const nodeId, int status);
+
+  /// Starts draining the queue once per frame.
+  void
+  start();
+
+  void
+  stop();
+
+  bool
+  isRunning() const { return _frameTimer.isActive(); }
+
+  /// 16 ms by default.
+  void
+  setFrameInterval(int msec);
+
+  /// Whether the nodes with a reported status are locked, `true` by default.
+  void
+  setLockingNodes(bool locking) { _lockingNodes = locking; }
+
+  bool
+  lockingNodes() const { return _lockingNodes; }
+
+public:
+  /// Thread-safe. Records rejected because the queue was full.
+  quint64
+  droppedCount() const;
+
+  /// Records taken from the queue.
+  quint64
+  receivedCount() const { return _receivedCount; }
+
+  /// Statuses applied to the scene, after coalescing.
+  quint64
+  appliedCount() const { return _appliedCount; }
+
+  /// Age in ms of the oldest record of the last frame when it was applied.
+  qint64
+  lastLag() const { return _lastLag; }
+
+  qint64
+  maxLag() const { return _maxLag; }
+
+  void
+  resetCounters();
+
+public Q_SLOTS:
+  /// Applies the queued statuses now.
+  void
+  drain();
+
+Q_SIGNALS:
+  /// The statuses applied by one frame, the latest one per node.
+  void
+  statusesApplied(std::vector<NodeStatusRecord> const & records);
+
+private:
+  BasicGraphicsScene & _scene;
+
+  std::unique_ptr<NodeStatusQueue> _queue;
+
+  QTimer _frameTimer;
+
+  bool _lockingNodes;
+
+  quint64 _receivedCount;
+
+  quint64 _appliedCount;
+
+  qint64 _lastLag;
+
+  qint64 _maxLag;
+
+  /// Reused by every frame, position of the node in `_frameRecords`.
+  std::unordered_map<NodeId, std::size_t> _frameIndex;
+
+  std::vector<NodeStatusRecord> _frameRecords;
+};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+#include <unordered_set>
+
+
+namespace QtNodes
+{
+
+class BasicGraphicsScene;
+class NodeStatusTimeline;
+
+/// Replays a NodeStatusTimeline on the scene.
+/**
+ * Once per frame the player advances its position by the elapsed time
+ * multiplied by the speed and applies the records passed over, the
+ * latest status per node, with one `BasicGraphicsScene::updateNodeStatuses`
+ * call. Seeking restores the full state at the target from the nearest
+ * keyframe; nodes without a status at the target lose theirs.
+ */
+class NODE_EDITOR_PUBLIC NodeStatusPlayer : public QObject
+{
+  Q_OBJECT
+
+public:
+  NodeStatusPlayer(BasicGraphicsScene & scene,
+                   NodeStatusTimeline & timeline,
+                   QObject * parent = nullptr);
+
+public:
+  /// Timestamp of the displayed state.
+  qint64
+  position() const { return _position; }
+
+  /// Playback rate, 1.0 is real time. Must be positive.
+  void
+  setSpeed(double speed);
+
+  double
+  speed() const { return _speed; }
+
+  /// 16 ms by default.
+  void
+  setFrameInterval(int msec);
+
+  /// Whether the replayed nodes are locked, `true` by default.
+  void
+  setLockingNodes(bool locking) { _lockingNodes = locking; }
+
+  bool
+  isPlaying() const { return _frameTimer.isActive(); }
+
+public Q_SLOTS:
+  /// Starts from the beginning when the position is outside of the timeline.
+  void
+  play();
+
+  void
+  pause();
+
+  /// Shows the state at `timestamp`, playing or not.
+  void
+  seek(qint64 timestamp);
+
+Q_SIGNALS:
+  void
+  positionChanged(qint64 timestamp);
+
+  /// The end of the timeline was reached.
+  void
+  finished();
+
+private Q_SLOTS:
+  void
+  advance();
+
+private:
+  /// Applies the records in [`_nextRecord`, `end`).
+  void
+  applyUntil(quint64 end);
+
+private:
+  BasicGraphicsScene & _scene;
+
+  NodeStatusTimeline & _timeline;
+
+  QTimer _frameTimer;
+
+  QElapsedTimer _clock;
+
+  double _speed;
+
+  bool _lockingNodes;
+
+  qint64 _position;
+
+  /// Fractional milliseconds left over by slow playback.
+  double _carry;
+
+  /// First record not applied yet.
+  quint64 _nextRecord;
+
+  /// Nodes given a status by the player, cleared when a seek drops it.
+  std::unordered_set<NodeId> _shownNodes;
+};
+
+}
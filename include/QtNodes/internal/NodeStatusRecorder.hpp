@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+#include "NodeStatusIngestor.hpp"
+
+#include <QtCore/QFile>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <unordered_map>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+/// Appends the displayed node statuses to a compact binary recording.
+/**
+ * Every status is a fixed-size 16 byte record. Every
+ * `keyframeInterval()` records the statuses of all the nodes seen so
+ * far are written to `<file>.index`, which lets NodeStatusTimeline
+ * restore the state at any time by reading at most one interval of
+ * records.
+ *
+ * Connect `NodeStatusIngestor::statusesApplied` to `record()` to keep
+ * what the monitor shows. Timestamps going back in time are clamped to
+ * the latest one, the recording stays sorted.
+ */
+class NODE_EDITOR_PUBLIC NodeStatusRecorder : public QObject
+{
+  Q_OBJECT
+
+public:
+  NodeStatusRecorder(QObject * parent = nullptr);
+
+  ~NodeStatusRecorder() override;
+
+public:
+  /// Starts a new recording, replacing the files.
+  bool
+  open(QString const & fileName);
+
+  void
+  close();
+
+  bool
+  isOpen() const { return _records.isOpen(); }
+
+  /// Records between two keyframes, 4096 by default.
+  void
+  setKeyframeInterval(int records);
+
+  int
+  keyframeInterval() const { return _keyframeInterval; }
+
+  quint64
+  recordCount() const { return _recordCount; }
+
+public Q_SLOTS:
+  void
+  record(std::vector<NodeStatusRecord> const & records);
+
+  void
+  append(NodeStatusRecord const & record);
+
+  void
+  flush();
+
+private:
+  bool
+  writeKeyframe();
+
+private:
+  QFile _records;
+
+  QFile _index;
+
+  int _keyframeInterval;
+
+  quint64 _recordCount;
+
+  qint64 _lastTimestamp;
+
+  /// Statuses after the last record, written by the keyframes.
+  std::unordered_map<NodeId, int> _state;
+};
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+#include "NodeStatusIngestor.hpp"
+
+#include <QtCore/QFile>
+#include <QtCore/QString>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+/// Random access to a recording written by NodeStatusRecorder.
+/**
+ * The records are read from the file on demand, only the keyframe
+ * index is kept in memory. Finding the record of a timestamp is a
+ * binary search over the fixed-size records, restoring the state at a
+ * timestamp starts from the preceding keyframe and reads at most one
+ * keyframe interval of records.
+ */
+class NODE_EDITOR_PUBLIC NodeStatusTimeline
+{
+public:
+  NodeStatusTimeline();
+
+  /// Opens a finished recording. A truncated last record is ignored.
+  bool
+  open(QString const & fileName);
+
+  void
+  close();
+
+  bool
+  isOpen() const { return _records.isOpen(); }
+
+  QString
+  errorString() const { return _errorString; }
+
+  quint64
+  recordCount() const { return _recordCount; }
+
+  /// Timestamp of the first record, 0 for empty recordings.
+  qint64
+  startTime() const { return _startTime; }
+
+  qint64
+  endTime() const { return _endTime; }
+
+  /// Number of records with a timestamp not after `timestamp`.
+  quint64
+  recordsUntil(qint64 timestamp);
+
+  /// Reads up to `count` records starting with the record `first`.
+  bool
+  readRecords(quint64 first,
+              quint64 count,
+              std::vector<NodeStatusRecord> & records);
+
+  /// Statuses of all the nodes once the records until `timestamp` applied.
+  bool
+  stateAt(qint64 timestamp, std::unordered_map<NodeId, int> & state);
+
+private:
+  struct Keyframe
+  {
+    quint64 recordIndex;
+
+    std::vector<std::pair<NodeId, int>> statuses;
+  };
+
+  bool
+  readHeader();
+
+  bool
+  readIndex(QString const & fileName);
+
+  bool
+  readTimestamp(quint64 index, qint64 & timestamp);
+
+  bool
+  fail(QString const & message);
+
+private:
+  QFile _records;
+
+  QString _errorString;
+
+  quint64 _recordCount;
+
+  qint64 _startTime;
+
+  qint64 _endTime;
+
+  /// Sorted by `recordIndex`.
+  std::vector<Keyframe> _keyframes;
+};
+
+}
@@ -50,5 +50,11 @@ public:
   float ConnectionPointDiameter;
 
   float Opacity;
+
+  /// Below this zoom level nodes are drawn as plain filled rectangles.
+  float LowDetailScale;
+
+  /// Below this zoom level the captions and port labels are omitted.
+  float MediumDetailScale;
 };
 }
@@ -6,6 +6,11 @@
 #include "GraphicsViewStyle.hpp"
 #include "NodeStyle.hpp"
 
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+
+#include <deque>
+
 namespace QtNodes
 {
 
@@ -16,6 +21,13 @@ public:
   static
   NodeStyle const & nodeStyle();
 
+  /// Style registered under `handle`, the global node style for 0.
+  /**
+   * Unknown handles fall back to the global node style as well.
+   */
+  static
+  NodeStyle const & nodeStyle(int handle);
+
   static
   ConnectionStyle const & connectionStyle();
 
@@ -33,6 +45,17 @@ public:
   static
   void setGraphicsViewStyle(GraphicsViewStyle);
 
+  /// Adds `style` to the palette and @returns its handle.
+  /**
+   * Models return the handle for NodeRole::StyleIndex, so that painters
+   * get the style by reference instead of parsing NodeRole::Style.
+   * Registered styles are never removed nor changed, register a new
+   * one for a different look. An equal style registered before keeps
+   * its handle, so every node of a model shares one entry.
+   */
+  static
+  int registerNodeStyle(NodeStyle style);
+
 private:
 
   StyleCollection() = default;
@@ -51,5 +74,11 @@ private:
   ConnectionStyle _connectionStyle;
 
   GraphicsViewStyle _flowViewStyle;
+
+  /// Handle `i` is `_nodeStyles[i - 1]`, the references stay valid.
+  std::deque<NodeStyle> _nodeStyles;
+
+  /// Handles by the compact JSON of the registered styles.
+  QHash<QByteArray, int> _nodeStyleHandles;
 };
 }
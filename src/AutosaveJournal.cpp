@@ -0,0 +1,572 @@
+#include "AutosaveJournal.hpp"
+
+#include "DataFlowGraphModel.hpp"
+#include "NodeDelegateModel.hpp"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+#include <QtCore/QSaveFile>
+#include <QtCore/QDebug>
+
+
+namespace QtNodes
+{
+
+namespace
+{
+
+constexpr quint32 JournalMagic = 0x4a4e5051; // "QNJN"
+
+constexpr char const * GenerationKey = "journal-generation";
+
+
+QByteArray
+compactJson(QJsonObject const & json)
+{
+  return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+
+QJsonObject
+parseJson(QByteArray const & bytes)
+{
+  return QJsonDocument::fromJson(bytes).object();
+}
+
+}
+
+
+AutosaveJournal::
+AutosaveJournal(DataFlowGraphModel &graphModel,
+                QString const & basePath,
+                QObject * parent)
+  : QObject(parent)
+  , _graphModel(graphModel)
+  , _basePath(basePath)
+  , _recording(false)
+  , _generation(0)
+  , _compactionThreshold(4 * 1024 * 1024)
+{
+  _stream.setVersion(QDataStream::Qt_5_12);
+
+  _flushTimer.setSingleShot(true);
+  _flushTimer.setInterval(1000);
+
+  connect(&_flushTimer, &QTimer::timeout, this, &AutosaveJournal::flush);
+}
+
+
+AutosaveJournal::
+~AutosaveJournal()
+{
+  stop();
+}
+
+
+QString
+AutosaveJournal::
+snapshotFileName() const
+{
+  return _basePath + QStringLiteral(".snapshot");
+}
+
+
+QString
+AutosaveJournal::
+journalFileName() const
+{
+  return _basePath + QStringLiteral(".journal");
+}
+
+
+bool
+AutosaveJournal::
+hasRecoveryData() const
+{
+  return QFile::exists(snapshotFileName());
+}
+
+
+bool
+AutosaveJournal::
+recover()
+{
+  if (_recording)
+    return false;
+
+  QFile file(snapshotFileName());
+
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QJsonObject const snapshot = parseJson(file.readAll());
+
+  if (snapshot.isEmpty())
+  {
+    qWarning() << "Autosave snapshot is corrupted:" << file.fileName();
+    return false;
+  }
+
+  _generation =
+    static_cast<quint64>(snapshot[GenerationKey].toVariant().toULongLong());
+
+  _graphModel.load(QJsonDocument(snapshot));
+
+  return replayJournal();
+}
+
+
+bool
+AutosaveJournal::
+start()
+{
+  if (_recording)
+    return true;
+
+  connect(&_graphModel, &AbstractGraphModel::nodeCreated,
+          this, &AutosaveJournal::onNodeCreated);
+
+  connect(&_graphModel, &AbstractGraphModel::nodeDeleted,
+          this, &AutosaveJournal::onNodeDeleted);
+
+  connect(&_graphModel, &AbstractGraphModel::nodePositionUpdated,
+          this, &AutosaveJournal::onNodePositionUpdated);
+
+  connect(&_graphModel, &AbstractGraphModel::nodeUpdated,
+          this, &AutosaveJournal::onNodeUpdated);
+
+  connect(&_graphModel, &AbstractGraphModel::connectionCreated,
+          this, &AutosaveJournal::onConnectionCreated);
+
+  connect(&_graphModel, &AbstractGraphModel::connectionDeleted,
+          this, &AutosaveJournal::onConnectionDeleted);
+
+  _recording = true;
+
+  if (!compact())
+  {
+    stop();
+    return false;
+  }
+
+  return true;
+}
+
+
+void
+AutosaveJournal::
+stop()
+{
+  if (!_recording)
+    return;
+
+  flush();
+
+  disconnect(&_graphModel, nullptr, this, nullptr);
+
+  _flushTimer.stop();
+
+  _stream.setDevice(nullptr);
+  _journal.close();
+
+  _recording = false;
+}
+
+
+void
+AutosaveJournal::
+discard()
+{
+  stop();
+
+  _pendingNodes.clear();
+  _pendingMoves.clear();
+  _pendingInternalData.clear();
+
+  QFile::remove(journalFileName());
+  QFile::remove(snapshotFileName());
+}
+
+
+void
+AutosaveJournal::
+setFlushInterval(int msec)
+{
+  _flushTimer.setInterval(msec);
+}
+
+
+void
+AutosaveJournal::
+setCompactionThreshold(qint64 bytes)
+{
+  _compactionThreshold = bytes;
+}
+
+
+void
+AutosaveJournal::
+flush()
+{
+  if (!_recording)
+    return;
+
+  _flushTimer.stop();
+
+  writePending();
+
+  _journal.flush();
+
+  if (_compactionThreshold > 0 && _journal.size() > _compactionThreshold)
+    compact();
+}
+
+
+bool
+AutosaveJournal::
+compact()
+{
+  if (!_recording)
+    return false;
+
+  _flushTimer.stop();
+
+  // The snapshot contains every pending change.
+  _pendingNodes.clear();
+  _pendingMoves.clear();
+  _pendingInternalData.clear();
+
+  quint64 const generation = _generation + 1;
+
+  QJsonObject snapshot = _graphModel.save().object();
+  snapshot[GenerationKey] = static_cast<qint64>(generation);
+
+  QSaveFile file(snapshotFileName());
+
+  if (!file.open(QIODevice::WriteOnly) ||
+      file.write(compactJson(snapshot)) < 0 ||
+      !file.commit())
+  {
+    qWarning() << "Could not write autosave snapshot:" << file.errorString();
+    return false;
+  }
+
+  // Records written with the old generation are ignored from now on,
+  // even if the process dies before the journal is truncated.
+  _generation = generation;
+
+  return openJournal(true);
+}
+
+
+void
+AutosaveJournal::
+onNodeCreated(NodeId const nodeId)
+{
+  _pendingNodes.insert(nodeId);
+
+  scheduleFlush();
+}
+
+
+void
+AutosaveJournal::
+onNodeDeleted(NodeId const nodeId)
+{
+  _pendingMoves.erase(nodeId);
+  _pendingInternalData.erase(nodeId);
+
+  // The node never reached the journal.
+  if (_pendingNodes.erase(nodeId) > 0)
+    return;
+
+  writePending();
+
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out << static_cast<quint32>(nodeId);
+
+  appendRecord(RecordType::NodeRemoved, payload);
+}
+
+
+void
+AutosaveJournal::
+onNodePositionUpdated(NodeId const nodeId)
+{
+  if (_pendingNodes.count(nodeId) == 0)
+    _pendingMoves.insert(nodeId);
+
+  scheduleFlush();
+}
+
+
+void
+AutosaveJournal::
+onNodeUpdated(NodeId const nodeId)
+{
+  if (_pendingNodes.count(nodeId) == 0)
+    _pendingInternalData.insert(nodeId);
+
+  scheduleFlush();
+}
+
+
+void
+AutosaveJournal::
+onConnectionCreated(ConnectionId const connectionId)
+{
+  writePending();
+
+  appendConnectionRecord(RecordType::ConnectionAdded, connectionId);
+}
+
+
+void
+AutosaveJournal::
+onConnectionDeleted(ConnectionId const connectionId)
+{
+  writePending();
+
+  appendConnectionRecord(RecordType::ConnectionRemoved, connectionId);
+}
+
+
+void
+AutosaveJournal::
+scheduleFlush()
+{
+  if (!_flushTimer.isActive())
+    _flushTimer.start();
+}
+
+
+void
+AutosaveJournal::
+writePending()
+{
+  for (NodeId const nodeId : _pendingNodes)
+  {
+    if (!_graphModel.nodeExists(nodeId))
+      continue;
+
+    appendRecord(RecordType::NodeAdded,
+                 compactJson(_graphModel.saveNode(nodeId)));
+  }
+  _pendingNodes.clear();
+
+  for (NodeId const nodeId : _pendingMoves)
+  {
+    QPointF const pos =
+      _graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << static_cast<quint32>(nodeId) << pos.x() << pos.y();
+
+    appendRecord(RecordType::NodeMoved, payload);
+  }
+  _pendingMoves.clear();
+
+  for (NodeId const nodeId : _pendingInternalData)
+  {
+    auto model = _graphModel.delegateModel<NodeDelegateModel>(nodeId);
+
+    if (!model)
+      continue;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << static_cast<quint32>(nodeId) << compactJson(model->save());
+
+    appendRecord(RecordType::InternalDataChanged, payload);
+  }
+  _pendingInternalData.clear();
+}
+
+
+void
+AutosaveJournal::
+appendRecord(RecordType type, QByteArray const & payload)
+{
+  if (!_journal.isOpen())
+    return;
+
+  _stream << static_cast<quint8>(type) << payload;
+}
+
+
+void
+AutosaveJournal::
+appendConnectionRecord(RecordType type, ConnectionId const & connectionId)
+{
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out << static_cast<quint32>(connectionId.outNodeId)
+      << static_cast<quint32>(connectionId.outPortIndex)
+      << static_cast<quint32>(connectionId.inNodeId)
+      << static_cast<quint32>(connectionId.inPortIndex);
+
+  appendRecord(type, payload);
+}
+
+
+bool
+AutosaveJournal::
+openJournal(bool truncate)
+{
+  _stream.setDevice(nullptr);
+  _journal.close();
+
+  _journal.setFileName(journalFileName());
+
+  QIODevice::OpenMode mode = QIODevice::WriteOnly;
+  if (truncate)
+    mode |= QIODevice::Truncate;
+  else
+    mode |= QIODevice::Append;
+
+  if (!_journal.open(mode))
+  {
+    qWarning() << "Could not open autosave journal:" << _journal.errorString();
+    return false;
+  }
+
+  _stream.setDevice(&_journal);
+
+  if (truncate)
+  {
+    _stream << JournalMagic << _generation;
+    _journal.flush();
+  }
+
+  return true;
+}
+
+
+bool
+AutosaveJournal::
+replayJournal()
+{
+  QFile file(journalFileName());
+
+  // A snapshot without a journal is a complete state.
+  if (!file.open(QIODevice::ReadOnly))
+    return true;
+
+  QDataStream in(&file);
+  in.setVersion(_stream.version());
+
+  quint32 magic = 0;
+  quint64 generation = 0;
+  in >> magic >> generation;
+
+  if (in.status() != QDataStream::Ok || magic != JournalMagic)
+  {
+    qWarning() << "Autosave journal is corrupted:" << file.fileName();
+    return true;
+  }
+
+  // Left over from a compaction interrupted after the snapshot commit.
+  if (generation != _generation)
+    return true;
+
+  while (!in.atEnd())
+  {
+    quint8 type = 0;
+    QByteArray payload;
+    in >> type >> payload;
+
+    // The tail record may be incomplete if the process died while
+    // writing it.
+    if (in.status() != QDataStream::Ok)
+      break;
+
+    QDataStream record(payload);
+    record.setVersion(in.version());
+
+    switch (static_cast<RecordType>(type))
+    {
+      case RecordType::NodeAdded:
+      {
+        QJsonObject const nodeJson = parseJson(payload);
+        NodeId const nodeId = static_cast<NodeId>(nodeJson["id"].toInt());
+
+        if (!nodeJson.isEmpty() && !_graphModel.nodeExists(nodeId))
+          _graphModel.loadNode(nodeJson);
+        break;
+      }
+
+      case RecordType::NodeRemoved:
+      {
+        quint32 nodeId = 0;
+        record >> nodeId;
+
+        if (_graphModel.nodeExists(nodeId))
+          _graphModel.deleteNode(nodeId);
+        break;
+      }
+
+      case RecordType::NodeMoved:
+      {
+        quint32 nodeId = 0;
+        double x = 0.0;
+        double y = 0.0;
+        record >> nodeId >> x >> y;
+
+        if (_graphModel.nodeExists(nodeId))
+          _graphModel.setNodeData(nodeId, NodeRole::Position, QPointF(x, y));
+        break;
+      }
+
+      case RecordType::ConnectionAdded:
+      case RecordType::ConnectionRemoved:
+      {
+        quint32 outNodeId = 0, outPortIndex = 0, inNodeId = 0, inPortIndex = 0;
+        record >> outNodeId >> outPortIndex >> inNodeId >> inPortIndex;
+
+        ConnectionId const connectionId{outNodeId, outPortIndex,
+                                        inNodeId, inPortIndex};
+
+        // The exact edge, other edges may leave the same output port.
+        bool const exists =
+          _graphModel.nodeExists(outNodeId) &&
+          _graphModel.connections(outNodeId, PortType::Out, outPortIndex)
+          .count(connectionId) > 0;
+
+        if (static_cast<RecordType>(type) == RecordType::ConnectionRemoved)
+        {
+          if (exists)
+            _graphModel.deleteConnection(connectionId);
+        }
+        else if (!exists &&
+                 _graphModel.nodeExists(outNodeId) &&
+                 _graphModel.nodeExists(inNodeId))
+        {
+          _graphModel.addConnection(connectionId);
+        }
+        break;
+      }
+
+      case RecordType::InternalDataChanged:
+      {
+        quint32 nodeId = 0;
+        QByteArray json;
+        record >> nodeId >> json;
+
+        if (auto model = _graphModel.delegateModel<NodeDelegateModel>(nodeId))
+          model->load(parseJson(json));
+        break;
+      }
+
+      default:
+        qWarning() << "Unknown autosave journal record" << type;
+        return true;
+    }
+  }
+
+  return true;
+}
+
+}
@@ -1,11 +1,13 @@
 #include "BasicGraphicsScene.hpp"
 
+#include <algorithm>
 #include <queue>
 #include <iostream>
 #include <stdexcept>
 #include <unordered_set>
 #include <utility>
 
+#include <QtGui/QPainterPath>
 #include <QtGui/QUndoStack>
 
 #include <QtWidgets/QGraphicsSceneMoveEvent>
@@ -14,31 +16,85 @@
 #include <QtCore/QBuffer>
 #include <QtCore/QByteArray>
 #include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
+#include <QtCore/QTimer>
 #include <QtCore/QtGlobal>
 
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionIdUtils.hpp"
+#include "ConnectionLayer.hpp"
 #include "GraphicsView.hpp"
+#include "NodeGeometry.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "NodePixmapCache.hpp"
+#include "SpatialIndex.hpp"
+#include "StyleCollection.hpp"
+#include "UndoCommands.hpp"
 
 
 namespace QtNodes
 {
 
+namespace
+{
+
+/// `true` when the model has this very edge.
+/**
+ * `AbstractGraphModel::connectionExists` of some models only tells
+ * whether the output port is connected at all.
+ */
+bool
+edgeExists(AbstractGraphModel const & model, ConnectionId const & connectionId)
+{
+  return model.nodeExists(connectionId.outNodeId) &&
+         model.connections(connectionId.outNodeId,
+                           PortType::Out,
+                           connectionId.outPortIndex).count(connectionId) > 0;
+}
+
+}
+
+
 BasicGraphicsScene::
 BasicGraphicsScene(AbstractGraphModel &graphModel,
-                   QObject *   parent)
+                   QObject *   parent,
+                   PopulationMode populationMode)
   : QGraphicsScene(parent)
   , _graphModel(graphModel)
   , _undoStack(new QUndoStack(this))
+  , _translatingNodes(false)
+  , _nodeDragGesture(0)
+  , _undoMemoryBudget(0)
+  , _batchDepth(0)
+  , _nodeIndex(std::make_unique<SpatialIndex<NodeId>>())
+  , _connectionIndex(std::make_unique<SpatialIndex<ConnectionId>>())
+  , _virtualized(false)
+  , _virtualizationMargin(0.5)
+  , _virtualizationScheduled(false)
+  , _modelNodeIndex(std::make_unique<SpatialIndex<NodeId>>())
+  , _modelConnectionIndex(std::make_unique<SpatialIndex<ConnectionId>>())
+  , _demotionScheduled(false)
+  , _populationTimer(nullptr)
+  , _populationTotal(0)
+  , _populationBudget(8)
+  , _populationOrderDirty(false)
+  , _selectionFlushScheduled(false)
+  , _statusFlushScheduled(false)
+  , _heatmap(nullptr)
 {
+  // Qt's BSP index is expensive to maintain for constantly moving
+  // items; point and rect queries go through `_nodeIndex` and
+  // `_connectionIndex` instead.
   setItemIndexMethod(QGraphicsScene::NoIndex);
 
 
+  connect(_undoStack, &QUndoStack::indexChanged,
+          this, &BasicGraphicsScene::enforceUndoMemoryBudget);
+
   connect(&_graphModel, &AbstractGraphModel::connectionCreated,
           this, &BasicGraphicsScene::onConnectionCreated);
 
@@ -57,6 +113,12 @@ BasicGraphicsScene(AbstractGraphModel &graphModel,
   connect(&_graphModel, &AbstractGraphModel::nodePositionUpdated,
           this, &BasicGraphicsScene::onNodePositionUpdated);
 
+  connect(&_graphModel, &AbstractGraphModel::nodeUpdated,
+          this, &BasicGraphicsScene::onNodeUpdated);
+
+  connect(&_graphModel, &AbstractGraphModel::nodeStyleChanged,
+          this, &BasicGraphicsScene::onNodeStyleChanged);
+
   connect(&_graphModel, &AbstractGraphModel::portsAboutToBeDeleted,
           this, &BasicGraphicsScene::onPortsAboutToBeDeleted);
 
@@ -66,224 +128,1402 @@ BasicGraphicsScene(AbstractGraphModel &graphModel,
   connect(&_graphModel, &AbstractGraphModel::portsAboutToBeInserted,
           this, &BasicGraphicsScene::onPortsAboutToBeInserted);
 
-  connect(&_graphModel, &AbstractGraphModel::portsInserted,
-          this, &BasicGraphicsScene::onPortsInserted);
+  connect(&_graphModel, &AbstractGraphModel::portsInserted,
+          this, &BasicGraphicsScene::onPortsInserted);
+
+  connect(&_graphModel, &AbstractGraphModel::batchUpdateStarted,
+          this, &BasicGraphicsScene::onBatchUpdateStarted);
+
+  connect(&_graphModel, &AbstractGraphModel::batchUpdateFinished,
+          this, &BasicGraphicsScene::onBatchUpdateFinished);
+
+  // Promoted connections return to the layer once released.
+  connect(this, &QGraphicsScene::selectionChanged,
+          this, &BasicGraphicsScene::scheduleConnectionDemotion);
+
+  connect(this, &BasicGraphicsScene::connectionHoverLeft,
+          this, &BasicGraphicsScene::scheduleConnectionDemotion);
+
+  if (populationMode == PopulationMode::Incremental)
+  {
+    auto const allNodeIds = _graphModel.allNodeIds();
+
+    _pendingNodes.assign(allNodeIds.begin(), allNodeIds.end());
+    _populationTotal = static_cast<int>(_pendingNodes.size());
+    _populationOrderDirty = true;
+
+    // Every chunk runs from the event loop, the scene stays responsive.
+    _populationTimer = new QTimer(this);
+    _populationTimer->setInterval(0);
+
+    connect(_populationTimer, &QTimer::timeout,
+            this, &BasicGraphicsScene::populateChunk);
+
+    _populationTimer->start();
+  }
+  else
+  {
+    traverseGraphAndPopulateGraphicsObjects();
+  }
+}
+
+
+BasicGraphicsScene::
+~BasicGraphicsScene() = default;
+
+AbstractGraphModel const &
+BasicGraphicsScene::
+graphModel() const
+{
+  return _graphModel;
+}
+
+
+AbstractGraphModel &
+BasicGraphicsScene::
+graphModel()
+{
+  return _graphModel;
+}
+
+
+QUndoStack &
+BasicGraphicsScene::
+undoStack()
+{
+  return *_undoStack;
+}
+
+
+std::unique_ptr<ConnectionGraphicsObject> const &
+BasicGraphicsScene::
+makeDraftConnection(ConnectionId const incompleteConnectionId)
+{
+  _draftConnection =
+    std::make_unique<ConnectionGraphicsObject>(*this,
+                                               incompleteConnectionId);
+
+  _draftConnection->grabMouse();
+
+  return _draftConnection;
+}
+
+
+void
+BasicGraphicsScene::
+resetDraftConnection()
+{
+  _draftConnection.reset();
+}
+
+
+void
+BasicGraphicsScene::
+clearScene()
+{
+  auto const &allNodeIds =
+    graphModel().allNodeIds();
+
+  for ( auto nodeId : allNodeIds)
+  {
+    graphModel().deleteNode(nodeId);
+  }
+}
+
+
+void
+BasicGraphicsScene::
+lockNode(const NodeId nodeId, bool locked)
+{
+  if (locked)
+    _lockedNodes.insert(nodeId);
+  else
+    _lockedNodes.erase(nodeId);
+
+  auto node = nodeGraphicsObject(nodeId);
+  if (node)
+  {
+    node->lock(locked);
+
+    size_t const n = _graphModel.nodeData(nodeId, NodeRole::NumberOfOutPorts).toUInt();
+    for (PortIndex portIndex = 0; portIndex < n; ++portIndex)
+    {
+      auto const& connected = _graphModel.connections(nodeId, PortType::Out, portIndex);
+
+      for (auto& cnId : connected)
+      {
+        auto cgo = connectionGraphicsObject(cnId);
+
+        if (cgo)
+        {
+          cgo->lock(locked);
+          cgo->update();
+        }
+      }
+    }
+
+    node->update();
+  }
+}
+
+void
+BasicGraphicsScene::
+setStatusStyles(std::vector<NodeStyle> styles)
+{
+  _statusStyles = std::move(styles);
+
+  // The same status may look different now.
+  if (_nodePixmapCache)
+    _nodePixmapCache->clear();
+
+  for (auto const & entry : _nodeStatuses)
+  {
+    _statusDirtyNodes.insert(entry.first);
+
+    for (auto const & connectionId : _graphModel.allConnectionIds(entry.first))
+    {
+      if (connectionId.inNodeId == entry.first)
+        _statusDirtyConnections.insert(connectionId);
+    }
+  }
+
+  scheduleStatusFlush();
+}
+
+
+void
+BasicGraphicsScene::
+updateNodeStatuses(std::vector<std::pair<NodeId, int>> const & statuses,
+                   bool locked)
+{
+  for (auto const & entry : statuses)
+  {
+    NodeId const nodeId = entry.first;
+    int const status = std::max(entry.second, -1);
+
+    if (!_graphModel.nodeExists(nodeId))
+      continue;
+
+    bool const statusChanged = nodeStatus(nodeId) != status;
+    bool const lockChanged = (_lockedNodes.count(nodeId) > 0) != locked;
+
+    if (!statusChanged && !lockChanged)
+      continue;
+
+    if (status < 0)
+      _nodeStatuses.erase(nodeId);
+    else
+      _nodeStatuses[nodeId] = status;
+
+    if (lockChanged)
+    {
+      if (locked)
+        _lockedNodes.insert(nodeId);
+      else
+        _lockedNodes.erase(nodeId);
+
+      if (auto node = nodeGraphicsObject(nodeId))
+        node->lock(locked);
+    }
+
+    _statusDirtyNodes.insert(nodeId);
+
+    // One model query per node covers the ports of both sides.
+    for (auto const & connectionId : _graphModel.allConnectionIds(nodeId))
+    {
+      // Connections take the color of the node they enter.
+      if (statusChanged && connectionId.inNodeId == nodeId)
+        _statusDirtyConnections.insert(connectionId);
+
+      if (lockChanged && connectionId.outNodeId == nodeId)
+      {
+        if (auto cgo = connectionGraphicsObject(connectionId))
+          cgo->lock(locked);
+      }
+    }
+  }
+
+  scheduleStatusFlush();
+}
+
+
+int
+BasicGraphicsScene::
+nodeStatus(NodeId const nodeId) const
+{
+  auto it = _nodeStatuses.find(nodeId);
+
+  return (it != _nodeStatuses.end()) ? it->second : -1;
+}
+
+
+void
+BasicGraphicsScene::
+setHeatmap(NodeHeatmap const * heatmap)
+{
+  _heatmap = heatmap;
+}
+
+
+void
+BasicGraphicsScene::
+updateHeatLevels(std::vector<NodeId> const & nodeIds, bool connections)
+{
+  for (NodeId const nodeId : nodeIds)
+  {
+    if (!_graphModel.nodeExists(nodeId))
+      continue;
+
+    _statusDirtyNodes.insert(nodeId);
+
+    if (!connections)
+      continue;
+
+    for (auto const & connectionId : _graphModel.allConnectionIds(nodeId))
+    {
+      if (connectionId.inNodeId == nodeId)
+        _statusDirtyConnections.insert(connectionId);
+    }
+  }
+
+  scheduleStatusFlush();
+}
+
+
+NodeStyle const &
+BasicGraphicsScene::
+nodeStyle(NodeId const nodeId) const
+{
+  int const status = nodeStatus(nodeId);
+
+  if (status >= 0 && status < static_cast<int>(_statusStyles.size()))
+    return _statusStyles[status];
+
+  QVariant const handle = _graphModel.nodeData(nodeId, NodeRole::StyleIndex);
+
+  if (handle.isValid())
+    return StyleCollection::nodeStyle(handle.toInt());
+
+  return parsedNodeStyle(nodeId).style;
+}
+
+
+QByteArray
+BasicGraphicsScene::
+nodeStyleKey(NodeId const nodeId) const
+{
+  QVariant const handle = _graphModel.nodeData(nodeId, NodeRole::StyleIndex);
+
+  if (handle.isValid())
+    return QByteArray::number(handle.toInt());
+
+  return parsedNodeStyle(nodeId).key;
+}
+
+
+BasicGraphicsScene::ParsedNodeStyle const &
+BasicGraphicsScene::
+parsedNodeStyle(NodeId const nodeId) const
+{
+  auto it = _parsedNodeStyles.find(nodeId);
+  if (it != _parsedNodeStyles.end())
+    return it->second;
+
+  QJsonDocument const json =
+    QJsonDocument::fromVariant(_graphModel.nodeData(nodeId, NodeRole::Style));
+
+  ParsedNodeStyle & parsed = _parsedNodeStyles[nodeId];
+  parsed.style = NodeStyle(json.object());
+  parsed.key = json.toJson(QJsonDocument::Compact);
+
+  return parsed;
+}
+
+
+NodeGraphicsObject*
+BasicGraphicsScene::
+nodeGraphicsObject(NodeId nodeId)
+{
+  NodeGraphicsObject * ngo = nullptr;
+  auto it = _nodeGraphicsObjects.find(nodeId);
+  if (it != _nodeGraphicsObjects.end())
+  {
+    ngo = it->second.get();
+  }
+
+  return ngo;
+}
+
+
+ConnectionGraphicsObject*
+BasicGraphicsScene::
+connectionGraphicsObject(ConnectionId connectionId)
+{
+  ConnectionGraphicsObject * cgo = nullptr;
+  auto it = _connectionGraphicsObjects.find(connectionId);
+  if (it != _connectionGraphicsObjects.end())
+  {
+    cgo = it->second.get();
+  }
+
+  return cgo;
+}
+
+
+QMenu *
+BasicGraphicsScene::
+createSceneMenu(QPointF const scenePos)
+{
+  Q_UNUSED(scenePos);
+  return nullptr;
+}
+
+std::vector<NodeId> BasicGraphicsScene::selectedNodes() const
+{
+  return std::vector<NodeId>(_selectedNodes.begin(), _selectedNodes.end());
+}
+
+
+std::vector<ConnectionId>
+BasicGraphicsScene::
+selectedConnections() const
+{
+  return std::vector<ConnectionId>(_selectedConnections.begin(),
+                                   _selectedConnections.end());
+}
+
+
+void
+BasicGraphicsScene::
+recordNodeSelection(NodeId const nodeId, bool selected)
+{
+  bool const wasSelected = _selectedNodes.count(nodeId) > 0;
+
+  if (selected == wasSelected)
+    return;
+
+  _nodeSelectionBefore.emplace(nodeId, wasSelected);
+
+  if (selected)
+    _selectedNodes.insert(nodeId);
+  else
+    _selectedNodes.erase(nodeId);
+
+  scheduleSelectionFlush();
+}
+
+
+void
+BasicGraphicsScene::
+recordConnectionSelection(ConnectionId const connectionId, bool selected)
+{
+  bool const wasSelected = _selectedConnections.count(connectionId) > 0;
+
+  if (selected == wasSelected)
+    return;
+
+  _connectionSelectionBefore.emplace(connectionId, wasSelected);
+
+  if (selected)
+    _selectedConnections.insert(connectionId);
+  else
+    _selectedConnections.erase(connectionId);
+
+  scheduleSelectionFlush();
+}
+
+std::vector<NodeGraphicsObject*>
+BasicGraphicsScene::
+nodesIn(QRectF const & sceneRect)
+{
+  updateSpatialIndex();
+
+  std::vector<NodeGraphicsObject*> result;
+
+  _nodeIndex->query(sceneRect,
+                    [&](NodeId const nodeId, QRectF const &)
+                    {
+                      result.push_back(_nodeGraphicsObjects.at(nodeId).get());
+                    });
+
+  return result;
+}
+
+
+std::vector<ConnectionGraphicsObject*>
+BasicGraphicsScene::
+connectionsIn(QRectF const & sceneRect)
+{
+  updateSpatialIndex();
+
+  std::vector<ConnectionGraphicsObject*> result;
+
+  _connectionIndex->query(sceneRect,
+                          [&](ConnectionId const & connectionId, QRectF const &)
+                          {
+                            result.push_back(_connectionGraphicsObjects.at(connectionId).get());
+                          });
+
+  return result;
+}
+
+
+void
+BasicGraphicsScene::
+setSelectionRect(QRectF const &             sceneRect,
+                 Qt::ItemSelectionOperation operation)
+{
+  QPainterPath area;
+  area.addRect(sceneRect);
+
+  std::unordered_set<QGraphicsItem*> hit;
+
+  auto collect =
+    [&](QGraphicsItem * item)
+    {
+      if (item->isVisible() &&
+          (item->flags() & QGraphicsItem::ItemIsSelectable) &&
+          item->collidesWithPath(item->mapFromScene(area), Qt::IntersectsItemShape))
+        hit.insert(item);
+    };
+
+  for (NodeGraphicsObject * ngo : nodesIn(sceneRect))
+    collect(ngo);
+
+  for (ConnectionGraphicsObject * cgo : connectionsIn(sceneRect))
+    collect(cgo);
+
+  if (operation == Qt::ReplaceSelection)
+  {
+    for (QGraphicsItem * item : selectedItems())
+    {
+      if (hit.count(item) == 0)
+        item->setSelected(false);
+    }
+  }
+
+  for (QGraphicsItem * item : hit)
+    item->setSelected(true);
+}
+
+
+NodeGraphicsObject *
+BasicGraphicsScene::
+nodeAt(QPointF const & scenePoint)
+{
+  updateSpatialIndex();
+
+  NodeGraphicsObject * result = nullptr;
+
+  _nodeIndex->query(scenePoint,
+                    [&](NodeId const nodeId, QRectF const &)
+                    {
+                      NodeGraphicsObject * ngo = _nodeGraphicsObjects.at(nodeId).get();
+
+                      if (!ngo->isVisible() ||
+                          !ngo->contains(ngo->mapFromScene(scenePoint)))
+                        return;
+
+                      // Equal z values stack in the order of addition.
+                      if (!result ||
+                          ngo->zValue() > result->zValue() ||
+                          (ngo->zValue() == result->zValue() &&
+                           ngo->stackingOrder() > result->stackingOrder()))
+                        result = ngo;
+                    });
+
+  return result;
+}
+
+
+void
+BasicGraphicsScene::
+invalidateNodeBounds(NodeId const nodeId)
+{
+  _dirtyNodeBounds.insert(nodeId);
+}
+
+
+void
+BasicGraphicsScene::
+invalidateConnectionBounds(ConnectionId const connectionId)
+{
+  _dirtyConnectionBounds.insert(connectionId);
+}
+
+
+void
+BasicGraphicsScene::
+updateSpatialIndex()
+{
+  for (NodeId const nodeId : _dirtyNodeBounds)
+  {
+    auto it = _nodeGraphicsObjects.find(nodeId);
+
+    if (it != _nodeGraphicsObjects.end())
+    {
+      QRectF const rect = it->second->sceneBoundingRect();
+
+      _nodeIndex->insert(nodeId, rect);
+
+      if (_virtualized)
+        indexModelNode(nodeId, rect);
+    }
+    else
+    {
+      _nodeIndex->remove(nodeId);
+    }
+  }
+  _dirtyNodeBounds.clear();
+
+  for (auto const & connectionId : _dirtyConnectionBounds)
+  {
+    auto it = _connectionGraphicsObjects.find(connectionId);
+
+    if (it != _connectionGraphicsObjects.end())
+      _connectionIndex->insert(connectionId, it->second->sceneBoundingRect());
+    else
+      _connectionIndex->remove(connectionId);
+  }
+  _dirtyConnectionBounds.clear();
+}
+
+
+void
+BasicGraphicsScene::
+setVirtualized(bool virtualized)
+{
+  if (virtualized == _virtualized)
+    return;
+
+  _virtualized = virtualized;
+
+  if (_virtualized)
+  {
+    updateSpatialIndex();
+
+    for (NodeId const nodeId : _graphModel.allNodeIds())
+    {
+      auto it = _nodeGraphicsObjects.find(nodeId);
+
+      indexModelNode(nodeId,
+                     (it != _nodeGraphicsObjects.end()) ?
+                     it->second->sceneBoundingRect() :
+                     estimatedNodeRect(nodeId));
+    }
+
+    scheduleVirtualizationUpdate();
+  }
+  else
+  {
+    _modelNodeIndex->clear();
+    _modelConnectionIndex->clear();
+
+    auto const allNodeIds = _graphModel.allNodeIds();
+
+    for (NodeId const nodeId : allNodeIds)
+    {
+      if (!nodeGraphicsObject(nodeId))
+        createNodeGraphicsObject(nodeId);
+    }
+
+    for (NodeId const nodeId : allNodeIds)
+    {
+      for (auto const & connectionId : _graphModel.allConnectionIds(nodeId))
+      {
+        if (!isConnectionMaterialized(connectionId))
+          materializeConnection(connectionId);
+      }
+    }
+  }
+}
+
+
+void
+BasicGraphicsScene::
+setVirtualizationMargin(qreal fraction)
+{
+  _virtualizationMargin = std::max<qreal>(fraction, 0.0);
+
+  scheduleVirtualizationUpdate();
+}
+
+
+void
+BasicGraphicsScene::
+setVisibleRect(QRectF const & sceneRect)
+{
+  if (sceneRect == _visibleRect)
+    return;
+
+  _visibleRect = sceneRect;
+
+  _populationOrderDirty = true;
+
+  scheduleVirtualizationUpdate();
+}
+
+
+void
+BasicGraphicsScene::
+setPopulationBudget(int milliseconds)
+{
+  _populationBudget = std::max(milliseconds, 1);
+}
+
+
+bool
+BasicGraphicsScene::
+isPopulating() const
+{
+  return _populationTimer && _populationTimer->isActive();
+}
+
+
+void
+BasicGraphicsScene::
+sortPendingNodes()
+{
+  _populationOrderDirty = false;
+
+  if (_visibleRect.isEmpty())
+    return;
+
+  QPointF const center = _visibleRect.center();
+
+  std::vector<std::pair<qreal, NodeId>> keyed;
+  keyed.reserve(_pendingNodes.size());
+
+  for (NodeId const nodeId : _pendingNodes)
+  {
+    QPointF const d =
+      _graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>() - center;
+
+    keyed.emplace_back(QPointF::dotProduct(d, d), nodeId);
+  }
+
+  // The farthest first, nodes are taken from the back.
+  std::sort(keyed.begin(), keyed.end(),
+            [](auto const & a, auto const & b) { return a.first > b.first; });
+
+  for (std::size_t i = 0; i < keyed.size(); ++i)
+    _pendingNodes[i] = keyed[i].second;
+}
+
+
+void
+BasicGraphicsScene::
+populateChunk()
+{
+  // The virtualization creates the objects near the view itself.
+  if (_virtualized)
+    _pendingNodes.clear();
+
+  if (_populationOrderDirty)
+    sortPendingNodes();
+
+  QElapsedTimer timer;
+  timer.start();
+
+  while (!_pendingNodes.empty() && timer.elapsed() < _populationBudget)
+  {
+    NodeId const nodeId = _pendingNodes.back();
+    _pendingNodes.pop_back();
+
+    // The model may have changed since the population started.
+    if (!_graphModel.nodeExists(nodeId) || nodeGraphicsObject(nodeId))
+      continue;
+
+    createNodeGraphicsObject(nodeId);
+
+    // Connections appear as soon as both of their ends exist.
+    for (auto const & connectionId : _graphModel.allConnectionIds(nodeId))
+    {
+      if (!isConnectionMaterialized(connectionId) &&
+          canMaterializeConnection(connectionId))
+        materializeConnection(connectionId);
+    }
+  }
+
+  Q_EMIT populationProgress(_populationTotal - static_cast<int>(_pendingNodes.size()),
+                            _populationTotal);
+
+  if (_pendingNodes.empty())
+  {
+    _populationTimer->stop();
+
+    Q_EMIT populationCompleted();
+  }
+}
+
+
+QRectF
+BasicGraphicsScene::
+estimatedNodeRect(NodeId const nodeId) const
+{
+  QPointF const pos =
+    _graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+
+  QSize size = _graphModel.nodeData(nodeId, NodeRole::Size).value<QSize>();
+
+  // The size is only known once the node has been laid out.
+  if (size.isEmpty())
+    size = QSize(120, 60);
+
+  return QRectF(pos, QSizeF(size));
+}
+
+
+void
+BasicGraphicsScene::
+indexModelNode(NodeId const nodeId, QRectF const & rect)
+{
+  _modelNodeIndex->insert(nodeId, rect);
+
+  for (auto const & connectionId : _graphModel.allConnectionIds(nodeId))
+  {
+    indexModelConnection(connectionId);
+  }
+}
+
+
+void
+BasicGraphicsScene::
+indexModelConnection(ConnectionId const connectionId)
+{
+  QRectF const outRect = _modelNodeIndex->rect(connectionId.outNodeId);
+  QRectF const inRect = _modelNodeIndex->rect(connectionId.inNodeId);
+
+  _modelConnectionIndex->insert(connectionId, outRect.united(inRect));
+}
+
+
+bool
+BasicGraphicsScene::
+isPinned(QGraphicsItem * item) const
+{
+  if (item->isSelected() || mouseGrabberItem() == item)
+    return true;
+
+  QGraphicsItem * focus = focusItem();
+
+  if (focus && (focus == item || item->isAncestorOf(focus)))
+    return true;
+
+  if (auto ngo = qgraphicsitem_cast<NodeGraphicsObject*>(item))
+    return ngo->nodeState().hovered();
+
+  if (auto cgo = qgraphicsitem_cast<ConnectionGraphicsObject*>(item))
+    return cgo->connectionState().hovered();
+
+  return false;
+}
+
+
+void
+BasicGraphicsScene::
+scheduleVirtualizationUpdate()
+{
+  if (!_virtualized || _virtualizationScheduled)
+    return;
+
+  _virtualizationScheduled = true;
+
+  // Deferred, so that no object is released from within its own event
+  // handler and a burst of changes is handled once.
+  QTimer::singleShot(0, this, &BasicGraphicsScene::updateVirtualization);
+}
+
+
+void
+BasicGraphicsScene::
+updateVirtualization()
+{
+  _virtualizationScheduled = false;
+
+  if (!_virtualized || _visibleRect.isEmpty() || _batchDepth > 0)
+    return;
+
+  updateSpatialIndex();
+
+  qreal const dx = _visibleRect.width() * _virtualizationMargin;
+  qreal const dy = _visibleRect.height() * _virtualizationMargin;
+
+  // New objects are created within `loadRect`, the existing ones are
+  // kept up to `keepRect`.
+  QRectF const loadRect = _visibleRect.adjusted(-dx, -dy, dx, dy);
+  QRectF const keepRect = _visibleRect.adjusted(-2 * dx, -2 * dy, 2 * dx, 2 * dy);
+
+  std::unordered_set<NodeId> nodes;
+  std::unordered_set<ConnectionId> connections;
+
+  _modelNodeIndex->query(keepRect,
+                         [&](NodeId const nodeId, QRectF const & rect)
+                         {
+                           if (rect.intersects(loadRect) ||
+                               _nodeGraphicsObjects.count(nodeId) > 0)
+                             nodes.insert(nodeId);
+                         });
+
+  _modelConnectionIndex->query(keepRect,
+                               [&](ConnectionId const & connectionId, QRectF const & rect)
+                               {
+                                 if (rect.intersects(loadRect) ||
+                                     isConnectionMaterialized(connectionId))
+                                   connections.insert(connectionId);
+                               });
+
+  for (auto const & entry : _nodeGraphicsObjects)
+  {
+    if (isPinned(entry.second.get()))
+      nodes.insert(entry.first);
+  }
+
+  for (auto const & entry : _connectionGraphicsObjects)
+  {
+    if (isPinned(entry.second.get()))
+      connections.insert(entry.first);
+  }
+
+  if (_draftConnection)
+  {
+    ConnectionId const draftId = _draftConnection->connectionId();
+
+    for (PortType const portType : {PortType::Out, PortType::In})
+    {
+      NodeId const nodeId = getNodeId(portType, draftId);
+
+      if (nodeId != InvalidNodeId)
+        nodes.insert(nodeId);
+    }
+  }
+
+  // Connections are positioned by their end nodes.
+  for (auto const & connectionId : connections)
+  {
+    nodes.insert(connectionId.outNodeId);
+    nodes.insert(connectionId.inNodeId);
+  }
+
+  for (auto it = _connectionGraphicsObjects.begin();
+       it != _connectionGraphicsObjects.end();)
+  {
+    if (connections.count(it->first) > 0)
+    {
+      ++it;
+      continue;
+    }
+
+    _connectionIndex->remove(it->first);
+    _dirtyConnectionBounds.erase(it->first);
+
+    it = _connectionGraphicsObjects.erase(it);
+  }
+
+  if (_connectionLayer)
+  {
+    for (auto const & connectionId : _connectionLayer->connections())
+    {
+      if (connections.count(connectionId) == 0)
+        _connectionLayer->removeConnection(connectionId);
+    }
+  }
+
+  for (auto it = _nodeGraphicsObjects.begin();
+       it != _nodeGraphicsObjects.end();)
+  {
+    if (nodes.count(it->first) > 0)
+    {
+      ++it;
+      continue;
+    }
+
+    _nodeIndex->remove(it->first);
+    _dirtyNodeBounds.erase(it->first);
+
+    // The embedded widget belongs to the delegate model and is reused
+    // when the node is materialized again.
+    it->second->detachEmbeddedWidget();
+
+    it = _nodeGraphicsObjects.erase(it);
+  }
+
+  for (NodeId const nodeId : nodes)
+  {
+    if (_nodeGraphicsObjects.count(nodeId) == 0 &&
+        _graphModel.nodeExists(nodeId))
+      createNodeGraphicsObject(nodeId);
+  }
+
+  for (auto const & connectionId : connections)
+  {
+    // The model position index may still hold removed edges.
+    if (!isConnectionMaterialized(connectionId) &&
+        edgeExists(_graphModel, connectionId))
+      materializeConnection(connectionId);
+  }
+}
+
+
+void
+BasicGraphicsScene::
+translateNodes(std::unordered_set<NodeId> const & nodeIds,
+               QPointF const &                    diff)
+{
+  std::unordered_set<ConnectionId> connections;
+
+  _translatingNodes = true;
+
+  for (NodeId const nodeId : nodeIds)
+  {
+    if (!_graphModel.nodeExists(nodeId))
+      continue;
+
+    QPointF const pos =
+      _graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+
+    _graphModel.setNodeData(nodeId, NodeRole::Position, pos + diff);
+
+    auto const attached = _graphModel.allConnectionIds(nodeId);
+    connections.insert(attached.begin(), attached.end());
+  }
+
+  _translatingNodes = false;
+
+  for (auto const & connectionId : connections)
+  {
+    updateConnectionGeometry(connectionId);
+  }
+}
+
+
+void
+BasicGraphicsScene::
+setUndoMemoryBudget(qint64 bytes)
+{
+  _undoMemoryBudget = bytes;
+
+  enforceUndoMemoryBudget();
+}
+
+
+namespace
+{
+
+qint64
+commandMemoryUsage(QUndoCommand const * command)
+{
+  if (auto payload = dynamic_cast<UndoPayload const *>(command))
+    return static_cast<qint64>(payload->memoryUsage());
+
+  return static_cast<qint64>(sizeof(QUndoCommand));
+}
+
+}
+
+
+qint64
+BasicGraphicsScene::
+undoMemoryUsage() const
+{
+  qint64 result = 0;
+
+  for (int i = 0; i < _undoStack->count(); ++i)
+  {
+    QUndoCommand const * command = _undoStack->command(i);
+
+    if (!command->isObsolete())
+      result += commandMemoryUsage(command);
+  }
+
+  return result;
+}
+
+
+void
+BasicGraphicsScene::
+enforceUndoMemoryBudget()
+{
+  if (_undoMemoryBudget <= 0)
+    return;
+
+  qint64 usage = undoMemoryUsage();
+
+  // Obsolete commands are skipped and deleted by QUndoStack when the
+  // history is undone down to them, so the evicted ones must form a
+  // prefix of the stack.
+  int const newest = _undoStack->index() - 1;
+
+  for (int i = 0; i < newest && usage > _undoMemoryBudget; ++i)
+  {
+    auto command = const_cast<QUndoCommand *>(_undoStack->command(i));
+
+    if (command->isObsolete())
+      continue;
+
+    usage -= commandMemoryUsage(command);
+
+    if (auto payload = dynamic_cast<UndoPayload *>(command))
+      payload->releasePayload();
+
+    command->setObsolete(true);
+  }
+}
+
+
+void
+BasicGraphicsScene::
+setNodeCacheBudget(qint64 bytes)
+{
+  if (bytes > 0)
+  {
+    if (_nodePixmapCache)
+      _nodePixmapCache->setBudget(bytes);
+    else
+      _nodePixmapCache = std::make_unique<NodePixmapCache>(bytes);
+  }
+  else
+  {
+    _nodePixmapCache.reset();
+  }
+
+  QGraphicsItem::CacheMode const mode =
+    _nodePixmapCache ?
+    QGraphicsItem::NoCache :
+    QGraphicsItem::DeviceCoordinateCache;
+
+  for (auto const & entry : _nodeGraphicsObjects)
+  {
+    entry.second->setCacheMode(mode);
+    entry.second->update();
+  }
+}
+
+
+qint64
+BasicGraphicsScene::
+nodeCacheBudget() const
+{
+  return _nodePixmapCache ? _nodePixmapCache->budget() : 0;
+}
+
+
+void
+BasicGraphicsScene::
+cleanupSceneMenu(QMenu* menu)
+{
+  Q_UNUSED(menu);
+}
+
+void
+BasicGraphicsScene::
+traverseGraphAndPopulateGraphicsObjects()
+{
+  auto allNodeIds = _graphModel.allNodeIds();
+
+  std::vector<ConnectionId> connectionsToCreate;
+
+  while (!allNodeIds.empty())
+  {
+    std::queue<NodeId> fifo;
+
+    auto firstId = *allNodeIds.begin();
+    allNodeIds.erase(firstId);
+
+    fifo.push(firstId);
+
+    while (!fifo.empty())
+    {
+      auto nodeId = fifo.front();
+      fifo.pop();
+
+      createNodeGraphicsObject(nodeId);
+
+      unsigned int nOutPorts =
+        _graphModel.nodeData(nodeId, NodeRole::NumberOfOutPorts).toUInt();
+
+      for (PortIndex index = 0; index < nOutPorts; ++index)
+      {
+        auto const& conns =
+          _graphModel.connections(nodeId,
+                                  PortType::Out,
+                                  index);
+
+        for (auto cn : conns)
+        {
+          fifo.push(cn.inNodeId);
+          allNodeIds.erase(cn.inNodeId);
+
+          connectionsToCreate.push_back(cn);
+        }
+      }
+    } // while
+  }
 
-  traverseGraphAndPopulateGraphicsObjects();
+  for (auto const & connectionId : connectionsToCreate)
+  {
+    materializeConnection(connectionId);
+  }
 }
 
 
+void
 BasicGraphicsScene::
-~BasicGraphicsScene() = default;
-
-AbstractGraphModel const &
-BasicGraphicsScene::
-graphModel() const
+createNodeGraphicsObject(NodeId const nodeId)
 {
-  return _graphModel;
+  auto caption = _graphModel.nodeData(nodeId, NodeRole::Caption).toString();
+  if ( caption != "Root")
+      _nodeGraphicsObjects[nodeId] =
+        std::make_unique<NodeGraphicsObject>(*this, nodeId);
+  else
+      _nodeGraphicsObjects[nodeId] =
+        std::make_unique<RootNodeObject>(*this, nodeId);
+
+  if (_lockedNodes.count(nodeId) > 0)
+    _nodeGraphicsObjects[nodeId]->lock(true);
+
+  invalidateNodeBounds(nodeId);
 }
 
 
-AbstractGraphModel &
+void
 BasicGraphicsScene::
-graphModel()
+createConnectionGraphicsObject(ConnectionId const connectionId)
 {
-  return _graphModel;
+  _connectionGraphicsObjects[connectionId] =
+    std::make_unique<ConnectionGraphicsObject>(*this,
+                                               connectionId);
+
+  if (_lockedNodes.count(connectionId.outNodeId) > 0)
+    _connectionGraphicsObjects[connectionId]->lock(true);
+
+  invalidateConnectionBounds(connectionId);
 }
 
 
-QUndoStack &
+void
 BasicGraphicsScene::
-undoStack()
+materializeConnection(ConnectionId const connectionId)
 {
-  return *_undoStack;
+  if (_connectionLayer)
+    _connectionLayer->addConnection(connectionId);
+  else
+    createConnectionGraphicsObject(connectionId);
 }
 
 
-std::unique_ptr<ConnectionGraphicsObject> const &
+bool
 BasicGraphicsScene::
-makeDraftConnection(ConnectionId const incompleteConnectionId)
+canMaterializeConnection(ConnectionId const connectionId)
 {
-  _draftConnection =
-    std::make_unique<ConnectionGraphicsObject>(*this,
-                                               incompleteConnectionId);
-
-  _draftConnection->grabMouse();
-
-  return _draftConnection;
+  return nodeGraphicsObject(connectionId.outNodeId) &&
+         nodeGraphicsObject(connectionId.inNodeId);
 }
 
 
-void
+bool
 BasicGraphicsScene::
-resetDraftConnection()
+isConnectionMaterialized(ConnectionId const connectionId) const
 {
-  _draftConnection.reset();
+  return _connectionGraphicsObjects.count(connectionId) > 0 ||
+         (_connectionLayer && _connectionLayer->hasConnection(connectionId));
 }
 
 
 void
 BasicGraphicsScene::
-clearScene()
+setConnectionLayer(bool enabled)
 {
-  auto const &allNodeIds =
-    graphModel().allNodeIds();
+  if (enabled == hasConnectionLayer())
+    return;
 
-  for ( auto nodeId : allNodeIds)
+  if (enabled)
   {
-    graphModel().deleteNode(nodeId);
+    _connectionLayer = std::make_unique<ConnectionLayer>(*this);
+
+    demoteConnections();
+  }
+  else
+  {
+    auto const connections = _connectionLayer->connections();
+
+    _connectionLayer.reset();
+
+    for (auto const & connectionId : connections)
+      createConnectionGraphicsObject(connectionId);
   }
 }
 
 
-void
+ConnectionGraphicsObject *
 BasicGraphicsScene::
-lockNode(const NodeId nodeId, bool locked)
+promoteConnection(ConnectionId const connectionId)
 {
-  auto node = nodeGraphicsObject(nodeId);
-  if (node)
-  {
-    node->lock(locked);
+  if (auto cgo = connectionGraphicsObject(connectionId))
+    return cgo;
 
-    size_t const n = _graphModel.nodeData(nodeId, NodeRole::NumberOfOutPorts).toUInt();
-    for (PortIndex portIndex = 0; portIndex < n; ++portIndex)
-    {
-      auto const& connected = _graphModel.connections(nodeId, PortType::Out, portIndex);
+  if (!edgeExists(_graphModel, connectionId) ||
+      !nodeGraphicsObject(connectionId.outNodeId) ||
+      !nodeGraphicsObject(connectionId.inNodeId))
+    return nullptr;
 
-      for (auto& cnId : connected)
-      {
-        auto cgo = connectionGraphicsObject(cnId);
+  if (_connectionLayer)
+    _connectionLayer->removeConnection(connectionId);
 
-        if (cgo)
-        {
-          cgo->lock(locked);
-          cgo->update();
-        }
-      }
-    }
+  createConnectionGraphicsObject(connectionId);
 
-    node->update();
-  }
+  return connectionGraphicsObject(connectionId);
 }
 
-NodeGraphicsObject*
+
+void
 BasicGraphicsScene::
-nodeGraphicsObject(NodeId nodeId)
+updateConnectionGeometry(ConnectionId const connectionId)
 {
-  NodeGraphicsObject * ngo = nullptr;
-  auto it = _nodeGraphicsObjects.find(nodeId);
-  if (it != _nodeGraphicsObjects.end())
-  {
-    ngo = it->second.get();
-  }
-
-  return ngo;
+  if (auto cgo = connectionGraphicsObject(connectionId))
+    cgo->move();
+  else if (_connectionLayer)
+    _connectionLayer->updateConnection(connectionId);
 }
 
 
-ConnectionGraphicsObject*
+void
 BasicGraphicsScene::
-connectionGraphicsObject(ConnectionId connectionId)
+scheduleConnectionDemotion()
 {
-  ConnectionGraphicsObject * cgo = nullptr;
-  auto it = _connectionGraphicsObjects.find(connectionId);
-  if (it != _connectionGraphicsObjects.end())
-  {
-    cgo = it->second.get();
-  }
+  if (!_connectionLayer || _demotionScheduled)
+    return;
 
-  return cgo;
+  _demotionScheduled = true;
+
+  // Deferred, the object may still be handling the event which
+  // released it.
+  QTimer::singleShot(0, this, &BasicGraphicsScene::demoteConnections);
 }
 
 
-QMenu *
+void
 BasicGraphicsScene::
-createSceneMenu(QPointF const scenePos)
+scheduleStatusFlush()
 {
-  Q_UNUSED(scenePos);
-  return nullptr;
+  if (_statusFlushScheduled ||
+      (_statusDirtyNodes.empty() && _statusDirtyConnections.empty()))
+    return;
+
+  _statusFlushScheduled = true;
+
+  QTimer::singleShot(0, this, &BasicGraphicsScene::flushStatusUpdates);
 }
 
-std::vector<NodeId> BasicGraphicsScene::selectedNodes() const
+
+void
+BasicGraphicsScene::
+flushStatusUpdates()
 {
-  QList<QGraphicsItem*> graphicsItems = selectedItems();
+  _statusFlushScheduled = false;
 
-  std::vector<NodeId> result;
-  result.reserve(graphicsItems.size());
+  for (NodeId const nodeId : _statusDirtyNodes)
+  {
+    if (auto node = nodeGraphicsObject(nodeId))
+      node->update();
+  }
 
-  for (QGraphicsItem* item : graphicsItems)
+  for (auto const & connectionId : _statusDirtyConnections)
   {
-    if (auto ngo = qgraphicsitem_cast<NodeGraphicsObject*>(item))
-    {
-      result.push_back(ngo->nodeId());
-    }
+    if (auto cgo = connectionGraphicsObject(connectionId))
+      cgo->update();
+    else if (_connectionLayer)
+      _connectionLayer->updateConnection(connectionId);
   }
-  return result;
+
+  _statusDirtyNodes.clear();
+  _statusDirtyConnections.clear();
 }
 
+
 void
 BasicGraphicsScene::
-cleanupSceneMenu(QMenu* menu)
+scheduleSelectionFlush()
 {
-  Q_UNUSED(menu);
+  if (_selectionFlushScheduled)
+    return;
+
+  _selectionFlushScheduled = true;
+
+  // Rubber band selection and `clearSelection` change many items at
+  // once, they are reported together.
+  QTimer::singleShot(0, this, &BasicGraphicsScene::flushSelectionChanges);
 }
 
+
 void
 BasicGraphicsScene::
-traverseGraphAndPopulateGraphicsObjects()
+flushSelectionChanges()
 {
-  auto allNodeIds = _graphModel.allNodeIds();
+  _selectionFlushScheduled = false;
 
-  std::vector<ConnectionId> connectionsToCreate;
+  std::vector<NodeId> selectedNodes;
+  std::vector<NodeId> deselectedNodes;
 
-  while (!allNodeIds.empty())
+  for (auto const & entry : _nodeSelectionBefore)
   {
-    std::queue<NodeId> fifo;
+    bool const selected = _selectedNodes.count(entry.first) > 0;
 
-    auto firstId = *allNodeIds.begin();
-    allNodeIds.erase(firstId);
+    if (selected != entry.second)
+      (selected ? selectedNodes : deselectedNodes).push_back(entry.first);
+  }
 
-    fifo.push(firstId);
+  std::vector<ConnectionId> selectedConnections;
+  std::vector<ConnectionId> deselectedConnections;
 
-    while (!fifo.empty())
-    {
-      auto nodeId = fifo.front();
-      fifo.pop();
+  for (auto const & entry : _connectionSelectionBefore)
+  {
+    bool const selected = _selectedConnections.count(entry.first) > 0;
 
-      auto caption = _graphModel.nodeData(nodeId, NodeRole::Caption).toString();
-      if ( caption != "Root")
-          _nodeGraphicsObjects[nodeId] =
-            std::make_unique<NodeGraphicsObject>(*this, nodeId);
-      else
-          _nodeGraphicsObjects[nodeId] =
-            std::make_unique<RootNodeObject>(*this, nodeId);
+    if (selected != entry.second)
+      (selected ? selectedConnections : deselectedConnections).push_back(entry.first);
+  }
 
-      unsigned int nOutPorts =
-        _graphModel.nodeData(nodeId, NodeRole::NumberOfOutPorts).toUInt();
+  _nodeSelectionBefore.clear();
+  _connectionSelectionBefore.clear();
 
-      for (PortIndex index = 0; index < nOutPorts; ++index)
-      {
-        auto const& conns =
-          _graphModel.connections(nodeId,
-                                  PortType::Out,
-                                  index);
+  if (selectedNodes.empty() && deselectedNodes.empty() &&
+      selectedConnections.empty() && deselectedConnections.empty())
+    return;
 
-        for (auto cn : conns)
-        {
-          fifo.push(cn.inNodeId);
-          allNodeIds.erase(cn.inNodeId);
+  Q_EMIT selectionSetChanged(selectedNodes,
+                             deselectedNodes,
+                             selectedConnections,
+                             deselectedConnections);
+}
 
-          connectionsToCreate.push_back(cn);
-        }
-      }
-    } // while
-  }
 
-  for (auto const & connectionId : connectionsToCreate)
+void
+BasicGraphicsScene::
+demoteConnections()
+{
+  _demotionScheduled = false;
+
+  if (!_connectionLayer)
+    return;
+
+  for (auto it = _connectionGraphicsObjects.begin();
+       it != _connectionGraphicsObjects.end();)
   {
-    _connectionGraphicsObjects[connectionId] =
-      std::make_unique<ConnectionGraphicsObject>(*this,
-                                                 connectionId);
+    if (isPinned(it->second.get()))
+    {
+      ++it;
+      continue;
+    }
+
+    ConnectionId const connectionId = it->first;
+
+    _connectionIndex->remove(connectionId);
+    _dirtyConnectionBounds.erase(connectionId);
+
+    it = _connectionGraphicsObjects.erase(it);
+
+    _connectionLayer->addConnection(connectionId);
   }
 }
 
@@ -298,6 +1538,8 @@ updateAttachedNodes(ConnectionId const connectionId,
 
   if (node)
   {
+    // The ports are drawn filled while connected.
+    node->invalidateContentKey();
     node->update();
   }
 }
@@ -307,12 +1549,24 @@ void
 BasicGraphicsScene::
 onConnectionDeleted(ConnectionId const connectionId)
 {
+  // Destroyed items do not notify the deselection.
+  recordConnectionSelection(connectionId, false);
+
+  _statusDirtyConnections.erase(connectionId);
+
   auto it = _connectionGraphicsObjects.find(connectionId);
   if (it != _connectionGraphicsObjects.end())
   {
     _connectionGraphicsObjects.erase(it);
   }
 
+  _connectionIndex->remove(connectionId);
+  _dirtyConnectionBounds.erase(connectionId);
+  _modelConnectionIndex->remove(connectionId);
+
+  if (_connectionLayer)
+    _connectionLayer->removeConnection(connectionId);
+
   // TODO: do we need it?
   if (_draftConnection &&
       _draftConnection->connectionId() == connectionId)
@@ -320,6 +1574,13 @@ onConnectionDeleted(ConnectionId const connectionId)
     _draftConnection.reset();
   }
 
+  if (_batchDepth > 0)
+  {
+    _batchTouchedNodes.insert(connectionId.outNodeId);
+    _batchTouchedNodes.insert(connectionId.inNodeId);
+    return;
+  }
+
   updateAttachedNodes(connectionId, PortType::Out);
   updateAttachedNodes(connectionId, PortType::In);
 }
@@ -329,9 +1590,24 @@ void
 BasicGraphicsScene::
 onConnectionCreated(ConnectionId const connectionId)
 {
-  _connectionGraphicsObjects[connectionId] =
-    std::make_unique<ConnectionGraphicsObject>(*this,
-                                               connectionId);
+  if (_batchDepth > 0)
+  {
+    _batchConnections.push_back(connectionId);
+    return;
+  }
+
+  if (_virtualized)
+    indexModelConnection(connectionId);
+
+  // The virtualization or the incremental population may not have
+  // created the nodes yet, they will add the connection later.
+  if (!canMaterializeConnection(connectionId))
+  {
+    scheduleVirtualizationUpdate();
+    return;
+  }
+
+  materializeConnection(connectionId);
 
   updateAttachedNodes(connectionId, PortType::Out);
   updateAttachedNodes(connectionId, PortType::In);
@@ -342,11 +1618,22 @@ void
 BasicGraphicsScene::
 onNodeDeleted(NodeId const nodeId)
 {
+  recordNodeSelection(nodeId, false);
+
+  _nodeStatuses.erase(nodeId);
+  _lockedNodes.erase(nodeId);
+  _parsedNodeStyles.erase(nodeId);
+  _statusDirtyNodes.erase(nodeId);
+
   auto it = _nodeGraphicsObjects.find(nodeId);
   if (it != _nodeGraphicsObjects.end())
   {
     _nodeGraphicsObjects.erase(it);
   }
+
+  _nodeIndex->remove(nodeId);
+  _dirtyNodeBounds.erase(nodeId);
+  _modelNodeIndex->remove(nodeId);
 }
 
 void
@@ -357,6 +1644,48 @@ onNodeResized(const NodeId nodeId)
   if (it != _nodeGraphicsObjects.end())
   {
     it->second->onNodeResized();
+
+    invalidateNodeBounds(nodeId);
+  }
+}
+
+void
+BasicGraphicsScene::
+onNodeUpdated(NodeId const nodeId)
+{
+  // The NodeRole::Style JSON may have changed with the node.
+  _parsedNodeStyles.erase(nodeId);
+
+  auto node = nodeGraphicsObject(nodeId);
+  if (!node)
+    return;
+
+  // A materialized lazy node has its widget now.
+  node->embedQWidget();
+
+  node->invalidateContentKey();
+
+  // Captions and port labels may depend on the internal data.
+  node->setGeometryChanged();
+
+  NodeGeometry(*node).recalculateSize();
+
+  node->update();
+  node->moveConnections();
+
+  invalidateNodeBounds(nodeId);
+}
+
+void
+BasicGraphicsScene::
+onNodeStyleChanged(NodeId const nodeId)
+{
+  _parsedNodeStyles.erase(nodeId);
+
+  if (auto node = nodeGraphicsObject(nodeId))
+  {
+    node->invalidateContentKey();
+    node->update();
   }
 }
 
@@ -364,13 +1693,82 @@ void
 BasicGraphicsScene::
 onNodeCreated(NodeId const nodeId)
 {
-    auto caption = _graphModel.nodeData(nodeId, NodeRole::Caption).toString();
-    if ( caption != "Root")
-        _nodeGraphicsObjects[nodeId] =
-          std::make_unique<NodeGraphicsObject>(*this, nodeId);
-    else
-        _nodeGraphicsObjects[nodeId] =
-          std::make_unique<RootNodeObject>(*this, nodeId);
+  if (_batchDepth > 0)
+  {
+    _batchNodes.push_back(nodeId);
+    return;
+  }
+
+  if (_virtualized)
+  {
+    indexModelNode(nodeId, estimatedNodeRect(nodeId));
+    scheduleVirtualizationUpdate();
+    return;
+  }
+
+  createNodeGraphicsObject(nodeId);
+}
+
+
+void
+BasicGraphicsScene::
+onBatchUpdateStarted()
+{
+  ++_batchDepth;
+}
+
+
+void
+BasicGraphicsScene::
+onBatchUpdateFinished()
+{
+  if (_batchDepth == 0 || --_batchDepth > 0)
+    return;
+
+  std::vector<NodeId> nodes;
+  nodes.swap(_batchNodes);
+
+  std::vector<ConnectionId> connections;
+  connections.swap(_batchConnections);
+
+  // Nodes and connections may have been removed later in the batch.
+  for (NodeId const nodeId : nodes)
+  {
+    if (!_graphModel.nodeExists(nodeId))
+      continue;
+
+    if (_virtualized)
+      indexModelNode(nodeId, estimatedNodeRect(nodeId));
+    else if (_nodeGraphicsObjects.find(nodeId) == _nodeGraphicsObjects.end())
+      createNodeGraphicsObject(nodeId);
+  }
+
+  std::unordered_set<NodeId> touchedNodes;
+  touchedNodes.swap(_batchTouchedNodes);
+
+  for (auto const & connectionId : connections)
+  {
+    // Edges created and removed again within the batch are skipped.
+    if (!edgeExists(_graphModel, connectionId))
+      continue;
+
+    if (_virtualized)
+      indexModelConnection(connectionId);
+    else if (canMaterializeConnection(connectionId))
+      materializeConnection(connectionId);
+
+    touchedNodes.insert(connectionId.outNodeId);
+    touchedNodes.insert(connectionId.inNodeId);
+  }
+
+  for (NodeId const nodeId : touchedNodes)
+  {
+    if (auto node = nodeGraphicsObject(nodeId))
+      node->update();
+  }
+
+  if (_virtualized)
+    scheduleVirtualizationUpdate();
 }
 
 
@@ -385,6 +1783,13 @@ onNodePositionUpdated(NodeId const nodeId)
                                       NodeRole::Position).value<QPointF>());
     node->update();
   }
+  else if (_virtualized)
+  {
+    indexModelNode(nodeId, estimatedNodeRect(nodeId));
+  }
+
+  if (_virtualized)
+    scheduleVirtualizationUpdate();
 }
 
 
@@ -434,6 +1839,7 @@ onPortsDeleted(NodeId const nodeId,
 
   if (node)
   {
+    node->invalidateContentKey();
     node->update();
   }
 }
@@ -457,9 +1863,14 @@ onPortsInserted(NodeId const nodeId,
                 PortType const portType,
                 std::unordered_set<PortIndex> const &portIndexSet)
 {
-  Q_UNUSED(nodeId);
   Q_UNUSED(portType);
   Q_UNUSED(portIndexSet);
+
+  if (auto node = nodeGraphicsObject(nodeId))
+  {
+    node->invalidateContentKey();
+    node->update();
+  }
 }
 
 void BasicGraphicsScene::onPortLayoutUpdated(PortLayout)
@@ -473,15 +1884,21 @@ void BasicGraphicsScene::onPortLayoutUpdated(PortLayout)
 
 void BasicGraphicsScene::onNodeColorUpdated(const NodeId nodeId)
 {
-  // to update the inner connection when status is changed
-  auto const& connected = graphModel().connections(nodeId, PortType::In, 0);
-  for (auto& cnId : connected)
+  // Connections take the color of the node they enter, on any port.
+  for (auto const & cnId : graphModel().allConnectionIds(nodeId))
   {
+    if (cnId.inNodeId != nodeId)
+      continue;
+
     auto cgo = connectionGraphicsObject(cnId);
     if (cgo)
     {
       cgo->update();
     }
+    else if (_connectionLayer)
+    {
+      _connectionLayer->updateConnection(cnId);
+    }
   }
 }
 }
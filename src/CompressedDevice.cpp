@@ -0,0 +1,265 @@
+#include "CompressedDevice.hpp"
+
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+
+
+namespace QtNodes
+{
+
+namespace
+{
+
+constexpr char const Magic[] = { 'Q', 'N', 'Z', '1' };
+
+constexpr int MagicSize = sizeof(Magic);
+
+constexpr int HeaderSize = MagicSize + 1;
+
+constexpr quint8 ZlibCodec = 1;
+
+}
+
+
+CompressedDevice::
+CompressedDevice(QIODevice & device, GraphCompression compression)
+  : _device(device)
+  , _compression(compression)
+  , _blockSize(256 * 1024)
+  , _blockPos(0)
+  , _finished(false)
+  , _error(false)
+{}
+
+
+CompressedDevice::
+~CompressedDevice()
+{
+  close();
+}
+
+
+bool
+CompressedDevice::
+isCompressed(QIODevice & device)
+{
+  QByteArray const header = device.peek(HeaderSize);
+
+  return header.size() == HeaderSize &&
+         header.startsWith(QByteArray::fromRawData(Magic, MagicSize)) &&
+         static_cast<quint8>(header[MagicSize]) == ZlibCodec;
+}
+
+
+void
+CompressedDevice::
+setBlockSize(int blockSize)
+{
+  _blockSize = std::max(blockSize, 1);
+}
+
+
+bool
+CompressedDevice::
+open(OpenMode mode)
+{
+  if (mode != ReadOnly && mode != WriteOnly)
+  {
+    setErrorString(QStringLiteral("Only ReadOnly or WriteOnly modes are supported"));
+    return false;
+  }
+
+  _block.clear();
+  _blockPos = 0;
+  _finished = false;
+  _error = false;
+
+  if (mode == WriteOnly)
+  {
+    if (_compression != GraphCompression::Zlib)
+    {
+      setErrorString(QStringLiteral("Unsupported codec"));
+      return false;
+    }
+
+    QByteArray header(Magic, MagicSize);
+    header.append(static_cast<char>(ZlibCodec));
+
+    if (_device.write(header) != header.size())
+    {
+      setErrorString(_device.errorString());
+      return false;
+    }
+  }
+  else
+  {
+    if (!isCompressed(_device))
+    {
+      setErrorString(QStringLiteral("Not a compressed graph stream"));
+      return false;
+    }
+
+    _device.read(HeaderSize);
+    _compression = GraphCompression::Zlib;
+  }
+
+  return QIODevice::open(mode);
+}
+
+
+void
+CompressedDevice::
+close()
+{
+  if (!isOpen())
+    return;
+
+  if (openMode() == WriteOnly)
+  {
+    // The remainder and the terminating empty block.
+    if (!_block.isEmpty())
+      writeBlock();
+    writeBlock();
+  }
+
+  _block.clear();
+  _blockPos = 0;
+
+  QIODevice::close();
+}
+
+
+qint64
+CompressedDevice::
+bytesAvailable() const
+{
+  qint64 const pending = (openMode() == ReadOnly) ? _block.size() - _blockPos : 0;
+
+  return pending + QIODevice::bytesAvailable();
+}
+
+
+qint64
+CompressedDevice::
+readData(char * data, qint64 maxSize)
+{
+  qint64 copied = 0;
+
+  while (copied < maxSize)
+  {
+    if (_blockPos == _block.size())
+    {
+      if (_finished || !readBlock())
+        break;
+
+      continue;
+    }
+
+    qint64 const n = std::min<qint64>(maxSize - copied, _block.size() - _blockPos);
+
+    std::copy_n(_block.constData() + _blockPos, n, data + copied);
+
+    _blockPos += static_cast<int>(n);
+    copied += n;
+  }
+
+  if (copied == 0 && !_finished)
+    return -1;
+
+  return copied;
+}
+
+
+qint64
+CompressedDevice::
+writeData(char const * data, qint64 maxSize)
+{
+  qint64 written = 0;
+
+  while (written < maxSize)
+  {
+    qint64 const n = std::min<qint64>(maxSize - written, _blockSize - _block.size());
+
+    _block.append(data + written, static_cast<int>(n));
+    written += n;
+
+    if (_block.size() >= _blockSize && !writeBlock())
+      return -1;
+  }
+
+  return written;
+}
+
+
+bool
+CompressedDevice::
+writeBlock()
+{
+  QByteArray const compressed =
+    _block.isEmpty() ? QByteArray() : qCompress(_block);
+
+  _block.clear();
+
+  uchar size[4];
+  qToBigEndian<quint32>(static_cast<quint32>(compressed.size()), size);
+
+  if (_device.write(reinterpret_cast<char const *>(size), 4) != 4 ||
+      _device.write(compressed) != compressed.size())
+  {
+    setErrorString(_device.errorString());
+    _error = true;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool
+CompressedDevice::
+readBlock()
+{
+  _block.clear();
+  _blockPos = 0;
+
+  QByteArray const sizeBytes = _device.read(4);
+
+  if (sizeBytes.size() != 4)
+  {
+    setErrorString(QStringLiteral("Truncated compressed graph stream"));
+    _error = true;
+    return false;
+  }
+
+  quint32 const size =
+    qFromBigEndian<quint32>(reinterpret_cast<uchar const *>(sizeBytes.constData()));
+
+  if (size == 0)
+  {
+    _finished = true;
+    return false;
+  }
+
+  QByteArray const compressed = _device.read(size);
+
+  if (compressed.size() != static_cast<int>(size))
+  {
+    setErrorString(QStringLiteral("Truncated compressed graph stream"));
+    _error = true;
+    return false;
+  }
+
+  _block = qUncompress(compressed);
+
+  if (_block.isEmpty())
+  {
+    setErrorString(QStringLiteral("Corrupted compressed graph stream"));
+    _error = true;
+    return false;
+  }
+
+  return true;
+}
+
+}
@@ -17,6 +17,7 @@
 #include "NodeConnectionInteraction.hpp"
 #include "NodeGeometry.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "NodeHeatmap.hpp"
 #include "StyleCollection.hpp"
 #include "locateNode.hpp"
 
@@ -215,6 +216,8 @@ move()
 
   prepareGeometryChange();
 
+  nodeScene()->invalidateConnectionBounds(_connectionId);
+
   update();
 }
 
@@ -241,6 +244,14 @@ connectionState()
 }
 
 ConnectionStyle ConnectionGraphicsObject::connectionStyle() const
+{
+  return connectionStyle(*nodeScene(), _connectionId);
+}
+
+ConnectionStyle
+ConnectionGraphicsObject::
+connectionStyle(BasicGraphicsScene const & scene,
+                ConnectionId const &       connectionId)
 {
   auto connectionStyle = StyleCollection::connectionStyle();
 
@@ -249,26 +260,49 @@ ConnectionStyle ConnectionGraphicsObject::connectionStyle() const
 
   const auto& defaultStyle = StyleCollection::nodeStyle();
 
-  auto inNodeStyle = _graphModel.nodeData(_connectionId.inNodeId, NodeRole::Style);
-  QJsonDocument json = QJsonDocument::fromVariant(inNodeStyle);
-  NodeStyle nodeStyle(json.object());
+  NodeStyle const & nodeStyle = scene.nodeStyle(connectionId.inNodeId);
 
   // In real-time monitoring mode, the color of the connection should be the same
   // as the NormalBoundaryColor.
   // We recognize this case by the fact that nodeStyle and defaultStyle are different
   if(defaultStyle.NormalBoundaryColor != nodeStyle.NormalBoundaryColor)
   {
-    auto connectionJson = connectionStyle.toJson();
-    auto connectionJsonObj = connectionJson["ConnectionStyle"].toObject();
-    connectionJsonObj["NormalColor"] = nodeStyle.NormalBoundaryColor.name();
-    connectionJson["ConnectionStyle"] = connectionJsonObj;
-    connectionStyle.loadJson(connectionJson);
+    connectionStyle.setNormalColor(nodeStyle.NormalBoundaryColor);
   }
   //-------------------------------------------
 
+  NodeHeatmap const * heatmap = scene.heatmap();
+
+  if (heatmap && heatmap->coloringConnections())
+  {
+    QColor heat = heatmap->color(connectionId.inNodeId);
+
+    // Opaque, the overlay alpha is meant for the node bodies.
+    if (heat.isValid())
+    {
+      heat.setAlpha(255);
+      connectionStyle.setNormalColor(heat);
+    }
+  }
+
   return connectionStyle;
 }
 
+QVariant
+ConnectionGraphicsObject::
+itemChange(GraphicsItemChange change, const QVariant& value)
+{
+  // The draft connection has no identity yet.
+  if (change == ItemSelectedHasChanged && scene() &&
+      !_connectionState.requiresPort())
+  {
+    nodeScene()->recordConnectionSelection(_connectionId, value.toBool());
+  }
+
+  return QGraphicsObject::itemChange(change, value);
+}
+
+
 void
 ConnectionGraphicsObject::
 paint(QPainter * painter,
@@ -280,7 +314,8 @@ paint(QPainter * painter,
 
   painter->setClipRect(option->exposedRect);
 
-  ConnectionPainter::paint(painter, *this);
+  ConnectionPainter::paint(painter, *this,
+                           option->levelOfDetailFromTransform(painter->worldTransform()));
 }
 
 
@@ -399,12 +434,21 @@ std::pair<QPointF, QPointF>
 ConnectionGraphicsObject::
 pointsC1C2() const
 {
-  auto const layout = graphModel().portLayout();
+  return pointsC1C2(_out, _in, graphModel().portLayout());
+}
+
+
+std::pair<QPointF, QPointF>
+ConnectionGraphicsObject::
+pointsC1C2(QPointF const & out,
+           QPointF const & in,
+           PortLayout const layout)
+{
   const double maxOffset = 200;
   const double minOffset = 40;
 
   double distance = ( layout == PortLayout::Horizontal ) ?
-    (_in.x() - _out.x()) : (_in.y() - _out.y());
+    (in.x() - out.x()) : (in.y() - out.y());
 
   double ratio = (distance <= 0) ? 1.0 : 0.4;
   double offset = std::abs(distance) * ratio;
@@ -412,13 +456,13 @@ pointsC1C2() const
 
   if( layout == PortLayout::Horizontal)
   {
-    QPointF c1(_out.x() + offset, _out.y());
-    QPointF c2(_in.x() - offset, _in.y());
+    QPointF c1(out.x() + offset, out.y());
+    QPointF c2(in.x() - offset, in.y());
     return std::make_pair(c1, c2);
   }
   else {
-    QPointF c1(_out.x(), _out.y() + offset);
-    QPointF c2(_in.x(), _in.y() - offset);
+    QPointF c1(out.x(), out.y() + offset);
+    QPointF c2(in.x(), in.y() - offset);
     return std::make_pair(c1, c2);
   }
 }
@@ -0,0 +1,390 @@
+#include "ConnectionLayer.hpp"
+
+#include <QtGui/QPainter>
+#include <QtWidgets/QGraphicsSceneContextMenuEvent>
+#include <QtWidgets/QGraphicsSceneHoverEvent>
+#include <QtWidgets/QGraphicsSceneMouseEvent>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+
+#include "AbstractGraphModel.hpp"
+#include "BasicGraphicsScene.hpp"
+#include "ConnectionGraphicsObject.hpp"
+#include "ConnectionIdUtils.hpp"
+#include "ConnectionStyle.hpp"
+#include "NodeData.hpp"
+#include "NodeGeometry.hpp"
+#include "NodeGraphicsObject.hpp"
+#include "StyleCollection.hpp"
+
+
+namespace QtNodes
+{
+
+namespace
+{
+
+/// Same as the stroke of `ConnectionPainter::getPainterStroke`.
+constexpr qreal HitWidth = 10.0;
+
+}
+
+
+ConnectionLayer::
+ConnectionLayer(BasicGraphicsScene & scene)
+  : _scene(scene)
+{
+  scene.addItem(this);
+
+  setAcceptHoverEvents(true);
+
+  // Below the promoted connections.
+  setZValue(-2.0);
+}
+
+
+void
+ConnectionLayer::
+addConnection(ConnectionId const connectionId)
+{
+  Edge & edge = _edges[connectionId];
+
+  QRectF const oldRect = _index.rect(connectionId);
+
+  computeEdge(connectionId, edge);
+
+  edgeChanged(connectionId, oldRect);
+}
+
+
+void
+ConnectionLayer::
+removeConnection(ConnectionId const connectionId)
+{
+  auto it = _edges.find(connectionId);
+  if (it == _edges.end())
+    return;
+
+  update(_index.rect(connectionId));
+
+  _index.remove(connectionId);
+  _edges.erase(it);
+}
+
+
+bool
+ConnectionLayer::
+hasConnection(ConnectionId const connectionId) const
+{
+  return _edges.count(connectionId) > 0;
+}
+
+
+void
+ConnectionLayer::
+updateConnection(ConnectionId const connectionId)
+{
+  auto it = _edges.find(connectionId);
+  if (it == _edges.end())
+    return;
+
+  QRectF const oldRect = _index.rect(connectionId);
+
+  computeEdge(connectionId, it->second);
+
+  edgeChanged(connectionId, oldRect);
+}
+
+
+std::vector<ConnectionId>
+ConnectionLayer::
+connections() const
+{
+  std::vector<ConnectionId> result;
+  result.reserve(_edges.size());
+
+  for (auto const & entry : _edges)
+    result.push_back(entry.first);
+
+  return result;
+}
+
+
+bool
+ConnectionLayer::
+connectionAt(QPointF const & scenePoint, ConnectionId & result) const
+{
+  QRectF const probe(scenePoint - QPointF(HitWidth, HitWidth) / 2.0,
+                     QSizeF(HitWidth, HitWidth));
+
+  bool found = false;
+
+  _index.query(probe,
+               [&](ConnectionId const & connectionId, QRectF const &)
+               {
+                 if (found)
+                   return;
+
+                 QPainterPathStroker stroker;
+                 stroker.setWidth(HitWidth);
+
+                 if (stroker.createStroke(_edges.at(connectionId).path).contains(scenePoint))
+                 {
+                   result = connectionId;
+                   found = true;
+                 }
+               });
+
+  return found;
+}
+
+
+QRectF
+ConnectionLayer::
+boundingRect() const
+{
+  return _boundingRect;
+}
+
+
+bool
+ConnectionLayer::
+contains(QPointF const & point) const
+{
+  // The layer stays at the scene origin, item and scene coordinates match.
+  ConnectionId connectionId;
+
+  return connectionAt(point, connectionId);
+}
+
+
+void
+ConnectionLayer::
+paint(QPainter * painter,
+      QStyleOptionGraphicsItem const * option,
+      QWidget *)
+{
+  qreal const lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+  auto const & style = StyleCollection::connectionStyle();
+
+  bool const straight = lod < style.lowDetailScale();
+  bool const endPoints = lod >= style.mediumDetailScale();
+
+  qreal const pointRadius = style.pointDiameter() / 2.0;
+
+  // The painter strokes each color group once.
+  std::unordered_map<QRgb, QPainterPath> paths;
+
+  QPainterPath points;
+
+  _index.query(option->exposedRect,
+               [&](ConnectionId const & connectionId, QRectF const &)
+               {
+                 Edge const & edge = _edges.at(connectionId);
+
+                 QPainterPath & path = paths[edge.color.rgba()];
+
+                 if (straight)
+                 {
+                   path.moveTo(edge.out);
+                   path.lineTo(edge.in);
+                 }
+                 else
+                 {
+                   path.addPath(edge.path);
+                 }
+
+                 if (endPoints)
+                 {
+                   points.addEllipse(edge.out, pointRadius, pointRadius);
+                   points.addEllipse(edge.in, pointRadius, pointRadius);
+                 }
+               });
+
+  painter->setBrush(Qt::NoBrush);
+
+  for (auto const & entry : paths)
+  {
+    QPen pen(QColor::fromRgba(entry.first),
+             straight ? 1.0 : style.lineWidth());
+    pen.setCosmetic(straight);
+
+    painter->setPen(pen);
+    painter->drawPath(entry.second);
+  }
+
+  if (!points.isEmpty())
+  {
+    painter->setPen(style.constructionColor());
+    painter->setBrush(style.constructionColor());
+    painter->drawPath(points);
+  }
+}
+
+
+void
+ConnectionLayer::
+hoverEnterEvent(QGraphicsSceneHoverEvent * event)
+{
+  promoteAt(event->scenePos());
+}
+
+
+void
+ConnectionLayer::
+hoverMoveEvent(QGraphicsSceneHoverEvent * event)
+{
+  promoteAt(event->scenePos());
+}
+
+
+void
+ConnectionLayer::
+mousePressEvent(QGraphicsSceneMouseEvent * event)
+{
+  ConnectionId connectionId;
+
+  auto cgo = connectionAt(event->scenePos(), connectionId) ?
+             _scene.promoteConnection(connectionId) :
+             nullptr;
+
+  // Presses on empty space go on to the scene, for the rubber band
+  // and for clearing the selection.
+  if (!cgo)
+  {
+    event->ignore();
+    return;
+  }
+
+  // As QGraphicsItem does for a selectable item. The event is accepted,
+  // an ignored press would make the scene clear the selection again.
+  if (event->modifiers() & Qt::ControlModifier)
+  {
+    cgo->setSelected(!cgo->isSelected());
+  }
+  else
+  {
+    _scene.clearSelection();
+    cgo->setSelected(true);
+  }
+
+  event->accept();
+}
+
+
+void
+ConnectionLayer::
+contextMenuEvent(QGraphicsSceneContextMenuEvent * event)
+{
+  ConnectionId connectionId;
+
+  if (connectionAt(event->scenePos(), connectionId))
+  {
+    _scene.promoteConnection(connectionId);
+
+    Q_EMIT _scene.connectionContextMenu(connectionId, event->scenePos());
+  }
+}
+
+
+void
+ConnectionLayer::
+computeEdge(ConnectionId const connectionId, Edge & edge) const
+{
+  edge.valid = true;
+
+  for (PortType const portType : {PortType::Out, PortType::In})
+  {
+    NodeGraphicsObject * ngo =
+      _scene.nodeGraphicsObject(getNodeId(portType, connectionId));
+
+    if (!ngo)
+    {
+      edge.valid = false;
+      continue;
+    }
+
+    QPointF const point =
+      NodeGeometry(*ngo).portScenePosition(portType,
+                                           getPortIndex(portType, connectionId),
+                                           ngo->sceneTransform());
+
+    if (portType == PortType::Out)
+      edge.out = point;
+    else
+      edge.in = point;
+  }
+
+  AbstractGraphModel const & graphModel = _scene.graphModel();
+
+  auto const c1c2 =
+    ConnectionGraphicsObject::pointsC1C2(edge.out, edge.in, graphModel.portLayout());
+
+  edge.path = QPainterPath(edge.out);
+  edge.path.cubicTo(c1c2.first, c1c2.second, edge.in);
+
+  ConnectionStyle const style =
+    ConnectionGraphicsObject::connectionStyle(_scene, connectionId);
+
+  if (style.useDataDefinedColors())
+  {
+    // Connections of mixed types are drawn in the color of the output.
+    auto const dataType =
+      graphModel.portData(connectionId.outNodeId,
+                          PortType::Out,
+                          connectionId.outPortIndex,
+                          PortRole::DataType).value<NodeDataType>();
+
+    edge.color = style.normalColor(dataType.id);
+  }
+  else
+  {
+    edge.color = style.normalColor();
+  }
+}
+
+
+void
+ConnectionLayer::
+edgeChanged(ConnectionId const connectionId, QRectF const & oldRect)
+{
+  Edge const & edge = _edges.at(connectionId);
+
+  if (!oldRect.isNull())
+    update(oldRect);
+
+  // Edges with an end outside of the scene are kept but not drawn.
+  if (!edge.valid)
+  {
+    _index.remove(connectionId);
+    return;
+  }
+
+  qreal const margin = StyleCollection::connectionStyle().pointDiameter();
+
+  QRectF const rect =
+    edge.path.boundingRect().adjusted(-margin, -margin, margin, margin);
+
+  _index.insert(connectionId, rect);
+
+  if (!_boundingRect.contains(rect))
+  {
+    prepareGeometryChange();
+    _boundingRect = _boundingRect.united(rect);
+  }
+
+  update(rect);
+}
+
+
+void
+ConnectionLayer::
+promoteAt(QPointF const & scenePoint)
+{
+  ConnectionId connectionId;
+
+  if (connectionAt(scenePoint, connectionId))
+    _scene.promoteConnection(connectionId);
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QtGui/QColor>
+#include <QtGui/QPainterPath>
+#include <QtWidgets/QGraphicsItem>
+
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionIdHash.hpp"
+#include "Definitions.hpp"
+#include "SpatialIndex.hpp"
+
+
+namespace QtNodes
+{
+
+class BasicGraphicsScene;
+
+/// One scene item drawing all the established connections.
+/**
+ * The connections in the layer have no ConnectionGraphicsObject. The
+ * layer keeps their geometry in a spatial index, paints the exposed
+ * ones with one path per color and hit-tests them itself. A connection
+ * under the mouse is promoted to a ConnectionGraphicsObject by the
+ * scene, which handles hovering, selection and dragging as usual.
+ */
+class ConnectionLayer : public QGraphicsItem
+{
+public:
+  // Needed for qgraphicsitem_cast
+  enum { Type = UserType + 3 };
+
+  int
+  type() const override { return Type; }
+
+public:
+  ConnectionLayer(BasicGraphicsScene & scene);
+
+  void
+  addConnection(ConnectionId const connectionId);
+
+  void
+  removeConnection(ConnectionId const connectionId);
+
+  bool
+  hasConnection(ConnectionId const connectionId) const;
+
+  /// Recomputes the end points and the color of the connection.
+  void
+  updateConnection(ConnectionId const connectionId);
+
+  std::vector<ConnectionId>
+  connections() const;
+
+  /// Finds the connection whose stroke contains `scenePoint`.
+  bool
+  connectionAt(QPointF const & scenePoint, ConnectionId & result) const;
+
+public:
+  QRectF
+  boundingRect() const override;
+
+  /// Only the strokes of the connections belong to the layer.
+  bool
+  contains(QPointF const & point) const override;
+
+protected:
+  void
+  paint(QPainter * painter,
+        QStyleOptionGraphicsItem const * option,
+        QWidget * widget = nullptr) override;
+
+  void
+  hoverEnterEvent(QGraphicsSceneHoverEvent * event) override;
+
+  void
+  hoverMoveEvent(QGraphicsSceneHoverEvent * event) override;
+
+  void
+  mousePressEvent(QGraphicsSceneMouseEvent * event) override;
+
+  void
+  contextMenuEvent(QGraphicsSceneContextMenuEvent * event) override;
+
+private:
+  struct Edge
+  {
+    QPointF out;
+    QPointF in;
+    QPainterPath path;
+    QColor color;
+    bool valid;
+  };
+
+  void
+  computeEdge(ConnectionId const connectionId, Edge & edge) const;
+
+  /// Repaints the old and the new area of the edge.
+  void
+  edgeChanged(ConnectionId const connectionId, QRectF const & oldRect);
+
+  void
+  promoteAt(QPointF const & scenePoint);
+
+private:
+  BasicGraphicsScene & _scene;
+
+  std::unordered_map<ConnectionId, Edge> _edges;
+
+  SpatialIndex<ConnectionId> _index;
+
+  /// Grows with the edges, which avoids re-indexing the whole layer.
+  QRectF _boundingRect;
+};
+
+}
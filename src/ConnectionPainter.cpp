@@ -266,11 +266,65 @@ drawNormalLine(QPainter * painter,
 }
 
 
+static
+void
+drawStraightLine(QPainter * painter,
+                 ConnectionGraphicsObject const &cgo)
+{
+  auto const& connectionStyle = cgo.connectionStyle();
+
+  QColor color = connectionStyle.normalColor();
+
+  if (connectionStyle.useDataDefinedColors())
+  {
+    auto const cId = cgo.connectionId();
+
+    auto dataTypeOut =
+      cgo.graphModel().portData(cId.outNodeId,
+                                PortType::Out,
+                                cId.outPortIndex,
+                                PortRole::DataType).value<NodeDataType>();
+
+    color = connectionStyle.normalColor(dataTypeOut.id);
+  }
+
+  if (cgo.isSelected())
+    color = connectionStyle.selectedHaloColor();
+
+  // One device pixel wide whatever the zoom.
+  QPen p(color, 1.0);
+  p.setCosmetic(true);
+
+  painter->setPen(p);
+  painter->setBrush(Qt::NoBrush);
+
+  painter->drawLine(cgo.out(), cgo.in());
+}
+
+
 void
 ConnectionPainter::
 paint(QPainter * painter,
-      ConnectionGraphicsObject const &cgo)
+      ConnectionGraphicsObject const &cgo,
+      qreal lod)
 {
+  auto const &style = QtNodes::StyleCollection::connectionStyle();
+
+  // The draft connection is always drawn in full.
+  bool const draft = cgo.connectionState().requiresPort();
+
+  if (!draft && lod < style.lowDetailScale())
+  {
+    drawStraightLine(painter, cgo);
+    return;
+  }
+
+  if (!draft && lod < style.mediumDetailScale())
+  {
+    drawNormalLine(painter, cgo);
+    return;
+  }
+
   drawHoveredOrSelected(painter, cgo);
 
   drawSketchLine(painter, cgo);
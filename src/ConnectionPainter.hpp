@@ -15,9 +15,11 @@ class ConnectionPainter
 {
 public:
 
+  /// `lod` is the zoom level, see `ConnectionStyle::lowDetailScale()`.
   static
   void paint(QPainter * painter,
-             ConnectionGraphicsObject const & cgo);
+             ConnectionGraphicsObject const & cgo,
+             qreal lod = 1.0);
 
   static
   QPainterPath getPainterStroke(ConnectionGraphicsObject const & cgo);
@@ -122,6 +122,9 @@ loadJson(QJsonObject const & json)
   CONNECTION_STYLE_READ_FLOAT(obj, PointDiameter);
 
   CONNECTION_STYLE_READ_BOOL(obj, UseDataDefinedColors);
+
+  CONNECTION_STYLE_READ_FLOAT(obj, LowDetailScale);
+  CONNECTION_STYLE_READ_FLOAT(obj, MediumDetailScale);
 }
 
 
@@ -143,6 +146,9 @@ toJson() const
 
   CONNECTION_STYLE_WRITE_BOOL(obj, UseDataDefinedColors);
 
+  CONNECTION_STYLE_WRITE_FLOAT(obj, LowDetailScale);
+  CONNECTION_STYLE_WRITE_FLOAT(obj, MediumDetailScale);
+
   QJsonObject root;
   root["ConnectionStyle"] = obj;
 
@@ -166,6 +172,14 @@ normalColor() const
 }
 
 
+void
+ConnectionStyle::
+setNormalColor(QColor const & color)
+{
+  NormalColor = color;
+}
+
+
 QColor
 ConnectionStyle::
 normalColor(QString typeId) const
@@ -240,3 +254,19 @@ useDataDefinedColors() const
 {
   return UseDataDefinedColors;
 }
+
+
+float
+ConnectionStyle::
+lowDetailScale() const
+{
+  return LowDetailScale;
+}
+
+
+float
+ConnectionStyle::
+mediumDetailScale() const
+{
+  return MediumDetailScale;
+}
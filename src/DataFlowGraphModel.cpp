@@ -1,19 +1,136 @@
 #include "DataFlowGraphModel.hpp"
 #include "ConnectionIdHash.hpp"
+#include "GraphStreamReader.hpp"
 
 #include <QJsonArray>
+#include <QJsonDocument>
+#include <QtCore/QIODevice>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
 
 namespace QtNodes
 {
 
+namespace
+{
+
+class FunctionRunnable : public QRunnable
+{
+public:
+  FunctionRunnable(std::function<void()> function)
+    : _function(std::move(function))
+  {}
+
+  void
+  run() override { _function(); }
+
+private:
+  std::function<void()> _function;
+};
+
+
+QJsonObject
+makeNodeJson(NodeId const        nodeId,
+             QJsonObject const & internalData,
+             QPointF const &     pos)
+{
+  QJsonObject nodeJson;
+
+  nodeJson["id"] = static_cast<qint64>(nodeId);
+
+  nodeJson["internal-data"] = internalData;
+
+  {
+    QJsonObject posJson;
+    posJson["x"] = pos.x();
+    posJson["y"] = pos.y();
+    nodeJson["position"] = posJson;
+  }
+
+  return nodeJson;
+}
+
+
+/// `json` as an element of the arrays written by `save(QIODevice&)`.
+QByteArray
+toRecord(QJsonObject const & json, QJsonDocument::JsonFormat format)
+{
+  QByteArray record = QJsonDocument(json).toJson(format);
+
+  if (format == QJsonDocument::Compact)
+    return record;
+
+  // Nested below the root object and the array, without the final newline.
+  record.chop(1);
+  record.replace("\n", "\n        ");
+  record.prepend("        ");
+
+  return record;
+}
+
+
+ConnectionId
+makeConnectionId(QJsonObject const & connJson)
+{
+  return ConnectionId{static_cast<NodeId>(connJson["outNodeId"].toInt()),
+                      static_cast<PortIndex>(connJson["outPortIndex"].toInt()),
+                      static_cast<NodeId>(connJson["intNodeId"].toInt()),
+                      static_cast<PortIndex>(connJson["inPortIndex"].toInt())};
+}
+
+}
+
 
 DataFlowGraphModel::
 DataFlowGraphModel(std::shared_ptr<NodeDelegateModelRegistry> registry)
   : _registry(std::move(registry))
   , _nextNodeId{0}
+  , _lazyLoading(false)
+  , _propagationSuspended(false)
+  , _nodeRecordsFormat(QJsonDocument::Indented)
 {}
 
 
+void
+DataFlowGraphModel::
+setLazyLoading(bool lazy)
+{
+  _lazyLoading = lazy;
+
+  if (!_lazyLoading)
+  {
+    std::vector<NodeId> placeholders;
+    placeholders.reserve(_lazyNodes.size());
+
+    for (auto const & p : _lazyNodes)
+    {
+      placeholders.push_back(p.first);
+    }
+
+    for (NodeId const nodeId : placeholders)
+    {
+      materialize(nodeId);
+    }
+  }
+}
+
+
+bool
+DataFlowGraphModel::
+isMaterialized(NodeId const nodeId) const
+{
+  auto it = _models.find(nodeId);
+
+  return it != _models.end() && it->second;
+}
+
+
 std::unordered_set<NodeId>
 DataFlowGraphModel::
 allNodeIds() const
@@ -105,7 +222,12 @@ connectionExists(ConnectionId const connectionId) const
                     PortType::Out,
                     getPortIndex(PortType::Out, connectionId));
 
-  return (_connectivity.find(key) != _connectivity.end());
+  auto it = _connectivity.find(key);
+
+  // The output port may feed other inputs, the edge itself must be there.
+  return (it != _connectivity.end()) &&
+         (it->second.count(std::make_pair(getNodeId(PortType::In, connectionId),
+                                          getPortIndex(PortType::In, connectionId))) > 0);
 }
 
 
@@ -119,9 +241,7 @@ addNode(QString const nodeType)
   {
     NodeId newId = newNodeId();
 
-    connect(model.get(), &NodeDelegateModel::dataUpdated,
-            [newId, this](PortIndex const portIndex)
-            { onOutPortDataUpdated(newId, portIndex); });
+    connectDelegateModel(newId, model.get());
 
     _models[newId] = std::move(model);
 
@@ -134,6 +254,32 @@ addNode(QString const nodeType)
 }
 
 
+void
+DataFlowGraphModel::
+connectDelegateModel(NodeId const nodeId, NodeDelegateModel * model)
+{
+  connect(model, &NodeDelegateModel::dataUpdated,
+          [nodeId, this](PortIndex const portIndex)
+          {
+            markNodeDirty(nodeId);
+            onOutPortDataUpdated(nodeId, portIndex);
+          });
+
+  connect(model, &NodeDelegateModel::internalDataChanged,
+          [nodeId, this]()
+          {
+            markNodeDirty(nodeId);
+            Q_EMIT nodeUpdated(nodeId);
+          });
+
+  connect(model, &NodeDelegateModel::nodeStyleChanged,
+          [nodeId, this]()
+          {
+            Q_EMIT nodeStyleChanged(nodeId);
+          });
+}
+
+
 bool
 DataFlowGraphModel::
 connectionPossible(ConnectionId const connectionId) const
@@ -209,12 +355,10 @@ nodeData(NodeId nodeId, NodeRole role) const
 {
   QVariant result;
 
-  auto it = _models.find(nodeId);
-  if (it == _models.end())
+  NodeDelegateModel const * model = descriptor(nodeId);
+  if (!model)
     return result;
 
-  auto& model = it->second;
-
   switch (role)
   {
     case NodeRole::Type:
@@ -238,17 +382,23 @@ nodeData(NodeId nodeId, NodeRole role) const
       break;
 
     case NodeRole::Style:
-    {
-      auto style = StyleCollection::nodeStyle();
-      result = style.toJson().toVariantMap();
-    }
-    break;
+      result = model->nodeStyle().toJson().toVariantMap();
+      break;
+
+    case NodeRole::StyleIndex:
+      result = model->nodeStyleHandle();
+      break;
 
     case NodeRole::InternalData:
     {
       QJsonObject nodeJson;
 
-      nodeJson["internal-data"] = _models.at(nodeId)->save();
+      auto lazyIt = _lazyNodes.find(nodeId);
+
+      if (lazyIt != _lazyNodes.end())
+        nodeJson["internal-data"] = lazyIt->second.internalData;
+      else
+        nodeJson["internal-data"] = _models.at(nodeId)->save();
 
       result = nodeJson.toVariantMap();
       break;
@@ -264,7 +414,14 @@ nodeData(NodeId nodeId, NodeRole role) const
 
     case NodeRole::Widget:
     {
-      auto w = model->embeddedWidget();
+      // Every graphics object asks for it, materializing here would
+      // defeat the lazy mode. The widget is embedded on `nodeUpdated`
+      // once the node has been materialized.
+      QWidget * w = nullptr;
+
+      if (isMaterialized(nodeId))
+        w = _models.at(nodeId)->embeddedWidget();
+
       result = QVariant::fromValue(w);
     }
     break;
@@ -278,9 +435,9 @@ NodeFlags
 DataFlowGraphModel::
 nodeFlags(NodeId nodeId) const
 {
-  auto it = _models.find(nodeId);
+  NodeDelegateModel const * model = descriptor(nodeId);
 
-  if (it != _models.end() && it->second->resizable())
+  if (model && model->resizable())
     return NodeFlag::Resizable;
 
   return NodeFlag::NoFlags;
@@ -307,6 +464,8 @@ setNodeData(NodeId   nodeId,
     {
       _nodeGeometryData[nodeId].pos = value.value<QPointF>();
 
+      markNodeDirty(nodeId);
+
       Q_EMIT nodePositionUpdated(nodeId);
 
       result = true;
@@ -329,6 +488,9 @@ setNodeData(NodeId   nodeId,
     case NodeRole::Style:
       break;
 
+    case NodeRole::StyleIndex:
+      break;
+
     case NodeRole::InternalData:
       break;
 
@@ -355,17 +517,16 @@ portData(NodeId    nodeId,
 {
   QVariant result;
 
-  auto it = _models.find(nodeId);
-  if (it == _models.end())
+  NodeDelegateModel const * model = descriptor(nodeId);
+  if (!model)
     return result;
 
-  auto& model = it->second;
-
   switch (role)
   {
     case PortRole::Data:
-      if (portType == PortType::Out)
-        result = QVariant::fromValue(model->outData(portIndex));
+      // Placeholders have not computed anything yet.
+      if (portType == PortType::Out && isMaterialized(nodeId))
+        result = QVariant::fromValue(_models.at(nodeId)->outData(portIndex));
       break;
 
     case PortRole::DataType:
@@ -405,12 +566,10 @@ setPortData(NodeId          nodeId,
 
   QVariant result;
 
-  auto it = _models.find(nodeId);
-  if (it == _models.end())
+  NodeDelegateModel * model = materialize(nodeId);
+  if (!model)
     return false;
 
-  auto& model = it->second;
-
   switch (role)
   {
     case PortRole::Data:
@@ -489,6 +648,8 @@ deleteNode(NodeId const nodeId)
   }
 
   _nodeGeometryData.erase(nodeId);
+  _nodeRecords.erase(nodeId);
+  _lazyNodes.erase(nodeId);
   _models.erase(nodeId);
 
   Q_EMIT nodeDeleted(nodeId);
@@ -501,23 +662,15 @@ QJsonObject
 DataFlowGraphModel::
 saveNode(NodeId const nodeId) const
 {
-  QJsonObject nodeJson;
-
-  nodeJson["id"] = static_cast<qint64>(nodeId);
-
-  nodeJson["internal-data"] = _models.at(nodeId)->save();
+  QPointF const pos =
+    nodeData(nodeId, NodeRole::Position).value<QPointF>();
 
-  {
-    QPointF const pos =
-      nodeData(nodeId, NodeRole::Position).value<QPointF>();
+  auto lazyIt = _lazyNodes.find(nodeId);
 
-    QJsonObject posJson;
-    posJson["x"] = pos.x();
-    posJson["y"] = pos.y();
-    nodeJson["position"] = posJson;
-  }
+  if (lazyIt != _lazyNodes.end())
+    return makeNodeJson(nodeId, lazyIt->second.internalData, pos);
 
-  return nodeJson;
+  return makeNodeJson(nodeId, _models.at(nodeId)->save(), pos);
 }
 
 
@@ -559,132 +712,941 @@ save() const
 }
 
 
-void
+bool
 DataFlowGraphModel::
-loadNode(QJsonObject const & nodeJson)
+save(QIODevice &               device,
+     GraphCompression          compression,
+     QJsonDocument::JsonFormat format) const
 {
-  NodeId restoredNodeId = static_cast<NodeId>(nodeJson["id"].toInt());
+  if (compression != GraphCompression::None)
+  {
+    CompressedDevice compressor(device, compression);
 
-  // Insert the desired next node id
-  setNextNodeId(restoredNodeId);
+    if (!compressor.open(QIODevice::WriteOnly) ||
+        !save(compressor, GraphCompression::None, format))
+      return false;
 
-  QJsonObject const internalDataJson = nodeJson["internal-data"].toObject();
+    compressor.close();
 
-  QString delegateModelName = internalDataJson["model-name"].toString();
+    return !compressor.hasError();
+  }
 
-  std::unique_ptr<NodeDelegateModel> model = _registry->create(delegateModelName);
+  std::vector<NodeId> nodeIds;
+  nodeIds.reserve(_models.size());
 
-  if (model)
+  for (auto const & p : _models)
   {
-    connect(model.get(), &NodeDelegateModel::dataUpdated,
-            [restoredNodeId, this](PortIndex const portIndex)
-            { onOutPortDataUpdated(restoredNodeId, portIndex); });
+    nodeIds.push_back(p.first);
+  }
 
-    _models[restoredNodeId] = std::move(model);
+  std::sort(nodeIds.begin(), nodeIds.end());
 
-    Q_EMIT nodeCreated(restoredNodeId);
+  // The cache holds the records of one format only.
+  if (_nodeRecordsFormat != format)
+  {
+    _nodeRecords.clear();
+    _nodeRecordsFormat = format;
+  }
 
-    QJsonObject posJson = nodeJson["position"].toObject();
-    QPointF const pos(posJson["x"].toDouble(),
-                      posJson["y"].toDouble());
+  serializeDirtyNodes(nodeIds);
 
-    setNodeData(restoredNodeId,
-                NodeRole::Position,
-                pos);
+  bool const indented = (format == QJsonDocument::Indented);
 
-    _models[restoredNodeId]->load(internalDataJson);
+  // The layout QJsonDocument itself produces.
+  char const * const firstSeparator = indented ? "\n" : "";
+  char const * const separator      = indented ? ",\n" : ",";
+  char const * const arrayEnd       = indented ? "\n    ]" : "]";
+
+  bool ok = device.write(indented ? "{\n    \"nodes\": [" : "{\"nodes\":[") >= 0;
+
+  for (std::size_t i = 0; ok && i < nodeIds.size(); ++i)
+  {
+    ok = device.write((i > 0) ? separator : firstSeparator) >= 0;
+
+    ok = ok && device.write(nodeRecord(nodeIds[i])) >= 0;
+  }
+
+  ok = ok && device.write(arrayEnd) >= 0;
+  ok = ok && device.write(indented ? ",\n    \"connections\": [" : ",\"connections\":[") >= 0;
+
+  bool first = true;
+  for (auto const & connPair : _connectivity)
+  {
+    ConnectivityKey const & key = connPair.first;
+
+    if (std::get<1>(key) != PortType::Out)
+      continue;
+
+    for (auto const & otherSide : connPair.second)
+    {
+      ConnectionId const connId{std::get<0>(key),
+                                std::get<2>(key),
+                                otherSide.first,
+                                otherSide.second};
+
+      ok = ok && device.write(first ? firstSeparator : separator) >= 0;
+      first = false;
+
+      ok = ok && device.write(toRecord(saveConnection(connId), format)) >= 0;
+    }
   }
+
+  ok = ok && device.write(arrayEnd) >= 0;
+  ok = ok && device.write(indented ? "\n}\n" : "}") >= 0;
+
+  return ok;
 }
 
 
 void
 DataFlowGraphModel::
-load(QJsonDocument const &json)
+markNodeDirty(NodeId const nodeId)
 {
-  QJsonObject const jsonDocument = json.object();
+  _nodeRecords.erase(nodeId);
+}
 
-  QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
 
-  for (QJsonValueRef node : nodesJsonArray)
+void
+DataFlowGraphModel::
+serializeDirtyNodes(std::vector<NodeId> const & nodeIds) const
+{
+  // Everything a worker needs is gathered here, so that the workers
+  // touch neither the hash maps nor the geometry data.
+  struct Job
+  {
+    NodeId nodeId;
+    NodeDelegateModel const * model;
+    QJsonObject const * internalData;
+    QPointF pos;
+  };
+
+  std::vector<Job> jobs;
+
+  for (NodeId const nodeId : nodeIds)
   {
-    loadNode(node.toObject());
+    if (_nodeRecords.count(nodeId) > 0)
+      continue;
+
+    NodeDelegateModel const * model = _models.at(nodeId).get();
+
+    auto lazyIt = _lazyNodes.find(nodeId);
+
+    if (lazyIt == _lazyNodes.end() && !model->saveIsThreadSafe())
+      continue;
+
+    auto geometryIt = _nodeGeometryData.find(nodeId);
+
+    QPointF const pos =
+      (geometryIt != _nodeGeometryData.end()) ? geometryIt->second.pos : QPointF();
+
+    jobs.push_back(Job{nodeId,
+                       model,
+                       (lazyIt != _lazyNodes.end()) ? &lazyIt->second.internalData : nullptr,
+                       pos});
   }
 
-  QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+  int const threadCount =
+    std::min<int>(QThread::idealThreadCount(), static_cast<int>(jobs.size()));
+
+  if (threadCount < 2)
+    return;
+
+  std::vector<QByteArray> records(jobs.size());
+
+  QJsonDocument::JsonFormat const format = _nodeRecordsFormat;
 
-  for (QJsonValueRef connection : connectionJsonArray)
   {
-    loadConnection(connection.toObject());
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+
+    std::size_t const rangeSize = (jobs.size() + threadCount - 1) / threadCount;
+
+    for (std::size_t begin = 0; begin < jobs.size(); begin += rangeSize)
+    {
+      std::size_t const end = std::min(begin + rangeSize, jobs.size());
+
+      pool.start(new FunctionRunnable(
+                   [&jobs, &records, format, begin, end]()
+                   {
+                     for (std::size_t i = begin; i < end; ++i)
+                     {
+                       Job const & job = jobs[i];
+
+                       QJsonObject const internalData =
+                         job.internalData ? *job.internalData : job.model->save();
+
+                       records[i] =
+                         toRecord(makeNodeJson(job.nodeId, internalData, job.pos), format);
+                     }
+                   }));
+    }
+
+    pool.waitForDone();
   }
-}
 
+  for (std::size_t i = 0; i < jobs.size(); ++i)
+  {
+    _nodeRecords.emplace(jobs[i].nodeId, std::move(records[i]));
+  }
+}
 
 
-QJsonObject
+QByteArray const &
 DataFlowGraphModel::
-saveConnection(ConnectionId const & connId) const
+nodeRecord(NodeId const nodeId) const
 {
-  QJsonObject connJson;
+  auto it = _nodeRecords.find(nodeId);
 
-  connJson["outNodeId"] = static_cast<qint64>(connId.outNodeId);
-  connJson["outPortIndex"] = static_cast<qint64>(connId.outPortIndex);
-  connJson["intNodeId"] = static_cast<qint64>(connId.inNodeId);
-  connJson["inPortIndex"] = static_cast<qint64>(connId.inPortIndex);
+  if (it == _nodeRecords.end())
+  {
+    QByteArray record = toRecord(saveNode(nodeId), _nodeRecordsFormat);
 
-  return connJson;
+    it = _nodeRecords.emplace(nodeId, std::move(record)).first;
+  }
+
+  return it->second;
 }
 
 
 void
 DataFlowGraphModel::
-loadConnection(QJsonObject const & connJson)
+loadNode(QJsonObject const & nodeJson)
 {
-  ConnectionId connId{static_cast<NodeId>(connJson["outNodeId"].toInt()),
-                      static_cast<PortIndex>(connJson["outPortIndex"].toInt()),
-                      static_cast<NodeId>(connJson["intNodeId"].toInt()),
-                      static_cast<PortIndex>(connJson["inPortIndex"].toInt())};
+  QJsonObject const internalDataJson = nodeJson["internal-data"].toObject();
+
+  QString delegateModelName = internalDataJson["model-name"].toString();
 
-  addConnection(connId);
+  if (_lazyLoading && deferrable(delegateModelName))
+    restorePlaceholder(nodeJson);
+  else
+    restoreNode(nodeJson, _registry->create(delegateModelName), true);
 }
 
 
 void
 DataFlowGraphModel::
-onOutPortDataUpdated(NodeId const    nodeId,
-                     PortIndex const portIndex)
+loadNodes(std::vector<QJsonObject> const & nodesJson)
 {
-  std::unordered_set<ConnectionId> const& connected =
-    connections(nodeId, PortType::Out, portIndex);
+  std::size_t const count = nodesJson.size();
 
-  QVariant const portDataToPropagate =
-    portData(nodeId, PortType::Out, portIndex, PortRole::Data);
+  std::vector<QJsonObject> internalData(count);
+  std::vector<std::unique_ptr<NodeDelegateModel>> models(count);
+  std::vector<char> deferred(count, 0);
 
-  for (auto const& cn : connected)
+  // Delegate models are QObjects, they must be created in the thread
+  // owning the graph model.
+  for (std::size_t i = 0; i < count; ++i)
   {
-    // When restoring a model from file, not all models are loaded simultaneously.
-    if (_models.find(cn.inNodeId) == _models.end())
-      continue;
+    internalData[i] = nodesJson[i]["internal-data"].toObject();
 
-    setPortData(cn.inNodeId, PortType::In,
-                cn.inPortIndex, portDataToPropagate,
-                PortRole::Data);
+    QString const modelName = internalData[i]["model-name"].toString();
 
-    // Maybe this call should be on the receiving side.
-    Q_EMIT inPortDataWasSet(cn.inNodeId, PortType::In, cn.inPortIndex);
+    if (_lazyLoading && deferrable(modelName))
+      deferred[i] = 1;
+    else
+      models[i] = _registry->create(modelName);
+  }
+
+  // `char` instead of `bool` so that workers never share a storage unit.
+  std::vector<char> prepared(count, 0);
+
+  int const threadCount =
+    std::min<int>(QThread::idealThreadCount(), static_cast<int>(count));
+
+  if (threadCount > 1)
+  {
+    std::atomic<std::size_t> next{0};
+
+    auto prepare =
+      [&]()
+      {
+        for (std::size_t i = next++; i < count; i = next++)
+        {
+          if (models[i])
+            prepared[i] = models[i]->prepareLoad(internalData[i]);
+        }
+      };
+
+    // The global pool keeps its threads between loads. The calling
+    // thread takes part, so the load goes on while the pool is busy.
+    QSemaphore finished;
+
+    for (int t = 1; t < threadCount; ++t)
+    {
+      QThreadPool::globalInstance()->start(new FunctionRunnable(
+                                             [&prepare, &finished]()
+                                             {
+                                               prepare();
+                                               finished.release();
+                                             }));
+    }
+
+    prepare();
+
+    finished.acquire(threadCount - 1);
+  }
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (deferred[i])
+      restorePlaceholder(nodesJson[i]);
+    else
+      restoreNode(nodesJson[i], std::move(models[i]), !prepared[i]);
   }
 }
 
 
 void
-
 DataFlowGraphModel::
-propagateEmptyDataTo(NodeId const    nodeId,
-                     PortIndex const portIndex)
+restoreNode(QJsonObject const &                nodeJson,
+            std::unique_ptr<NodeDelegateModel> model,
+            bool                               loadInternalData)
 {
-  auto const emptyData = std::shared_ptr<NodeData>();
+  NodeId restoredNodeId = static_cast<NodeId>(nodeJson["id"].toInt());
+
+  // Insert the desired next node id
+  setNextNodeId(restoredNodeId);
+
+  if (model)
+  {
+    connectDelegateModel(restoredNodeId, model.get());
+
+    markNodeDirty(restoredNodeId);
+
+    _models[restoredNodeId] = std::move(model);
+
+    Q_EMIT nodeCreated(restoredNodeId);
+
+    QJsonObject posJson = nodeJson["position"].toObject();
+    QPointF const pos(posJson["x"].toDouble(),
+                      posJson["y"].toDouble());
+
+    setNodeData(restoredNodeId,
+                NodeRole::Position,
+                pos);
+
+    if (loadInternalData)
+      _models[restoredNodeId]->load(nodeJson["internal-data"].toObject());
+  }
+}
+
+
+void
+DataFlowGraphModel::
+restorePlaceholder(QJsonObject const & nodeJson)
+{
+  NodeId restoredNodeId = static_cast<NodeId>(nodeJson["id"].toInt());
+
+  setNextNodeId(restoredNodeId);
+
+  QJsonObject const internalDataJson = nodeJson["internal-data"].toObject();
+
+  markNodeDirty(restoredNodeId);
+
+  _models[restoredNodeId] = nullptr;
+  _lazyNodes[restoredNodeId] =
+    LazyNode{internalDataJson["model-name"].toString(), internalDataJson};
+
+  Q_EMIT nodeCreated(restoredNodeId);
+
+  QJsonObject posJson = nodeJson["position"].toObject();
+  QPointF const pos(posJson["x"].toDouble(),
+                    posJson["y"].toDouble());
+
+  setNodeData(restoredNodeId,
+              NodeRole::Position,
+              pos);
+}
+
+
+bool
+DataFlowGraphModel::
+deferrable(QString const & modelName) const
+{
+  NodeDelegateModel const * model = prototype(modelName);
+
+  return model && model->allowsDeferredLoad();
+}
+
+
+NodeDelegateModel const *
+DataFlowGraphModel::
+prototype(QString const & modelName) const
+{
+  auto it = _prototypes.find(modelName);
+
+  if (it == _prototypes.end())
+    it = _prototypes.emplace(modelName, _registry->create(modelName)).first;
+
+  return it->second.get();
+}
+
+
+NodeDelegateModel const *
+DataFlowGraphModel::
+descriptor(NodeId const nodeId) const
+{
+  auto it = _models.find(nodeId);
+  if (it == _models.end())
+    return nullptr;
+
+  if (it->second)
+    return it->second.get();
+
+  return prototype(_lazyNodes.at(nodeId).modelName);
+}
+
+
+NodeDelegateModel *
+DataFlowGraphModel::
+materialize(NodeId const nodeId)
+{
+  auto it = _models.find(nodeId);
+  if (it == _models.end())
+    return nullptr;
+
+  if (it->second)
+    return it->second.get();
+
+  // Depth-first over the upstream placeholders with an explicit stack,
+  // long chains must not exhaust the call stack. `order` ends up with
+  // the sources before the nodes they feed.
+  std::vector<NodeId> order;
+  std::vector<std::pair<NodeId, bool>> stack{{nodeId, false}};
+
+  while (!stack.empty())
+  {
+    auto const entry = stack.back();
+    stack.pop_back();
+
+    if (entry.second)
+    {
+      order.push_back(entry.first);
+      continue;
+    }
+
+    // Created on discovery, so that cycles terminate.
+    if (isMaterialized(entry.first) || !createMaterializedModel(entry.first))
+      continue;
+
+    stack.emplace_back(entry.first, true);
+
+    unsigned int const nInPorts = _models[entry.first]->nPorts(PortType::In);
+
+    for (PortIndex portIndex = 0; portIndex < nInPorts; ++portIndex)
+    {
+      for (auto const & cn : connections(entry.first, PortType::In, portIndex))
+      {
+        if (!isMaterialized(cn.outNodeId))
+          stack.emplace_back(cn.outNodeId, false);
+      }
+    }
+  }
+
+  for (NodeId const materializedId : order)
+  {
+    NodeDelegateModel * model = _models[materializedId].get();
+
+    // Placeholders never receive data, the inputs are pulled now.
+    unsigned int const nInPorts = model->nPorts(PortType::In);
+
+    for (PortIndex portIndex = 0; portIndex < nInPorts; ++portIndex)
+    {
+      for (auto const & cn : connections(materializedId, PortType::In, portIndex))
+      {
+        if (isMaterialized(cn.outNodeId))
+          model->setInData(_models[cn.outNodeId]->outData(cn.outPortIndex), portIndex);
+      }
+    }
+
+    // The downstream nodes get the outputs and the scene embeds the
+    // widget once the caller, possibly a const accessor, has returned.
+    QMetaObject::invokeMethod(this,
+                              [this, materializedId]()
+                              {
+                                if (!isMaterialized(materializedId))
+                                  return;
+
+                                unsigned int const nOutPorts =
+                                  _models[materializedId]->nPorts(PortType::Out);
+
+                                for (PortIndex p = 0; p < nOutPorts; ++p)
+                                {
+                                  onOutPortDataUpdated(materializedId, p);
+                                }
+
+                                Q_EMIT nodeUpdated(materializedId);
+                              },
+                              Qt::QueuedConnection);
+  }
+
+  return _models[nodeId].get();
+}
+
+
+bool
+DataFlowGraphModel::
+materializeNode(NodeId const nodeId)
+{
+  return materialize(nodeId) != nullptr;
+}
+
+
+bool
+DataFlowGraphModel::
+createMaterializedModel(NodeId const nodeId)
+{
+  auto lazyIt = _lazyNodes.find(nodeId);
+  if (lazyIt == _lazyNodes.end())
+    return false;
+
+  std::unique_ptr<NodeDelegateModel> model = _registry->create(lazyIt->second.modelName);
+
+  if (!model)
+    return false;
+
+  LazyNode const lazyNode = std::move(lazyIt->second);
+  _lazyNodes.erase(lazyIt);
+
+  connectDelegateModel(nodeId, model.get());
+
+  model->load(lazyNode.internalData);
+
+  _models[nodeId] = std::move(model);
+
+  return true;
+}
+
+
+void
+DataFlowGraphModel::
+load(QJsonDocument const &json)
+{
+  QJsonObject const jsonDocument = json.object();
+
+  QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+
+  std::vector<QJsonObject> nodesJson;
+  nodesJson.reserve(nodesJsonArray.size());
+
+  for (QJsonValueRef node : nodesJsonArray)
+  {
+    nodesJson.push_back(node.toObject());
+  }
+
+  loadNodes(nodesJson);
+
+  QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+
+  for (QJsonValueRef connection : connectionJsonArray)
+  {
+    loadConnection(connection.toObject());
+  }
+}
+
+
+
+bool
+DataFlowGraphModel::
+load(QIODevice &                         device,
+     GraphStreamReader::ProgressCallback progress)
+{
+  _errorString.clear();
+
+  GraphStreamReader reader(*this);
+
+  // The reader counts the uncompressed bytes, the progress refers to
+  // the device. Sockets and pipes have neither a position nor a size,
+  // the bytes consumed by the reader are reported instead.
+  if (progress)
+  {
+    bool const sequential = device.isSequential();
+
+    reader.setProgressCallback(
+      [&device, progress, sequential](qint64 processed, qint64)
+      {
+        if (sequential)
+          progress(processed, -1);
+        else
+          progress(device.pos(), device.size());
+      });
+  }
+
+  if (CompressedDevice::isCompressed(device))
+  {
+    CompressedDevice decompressor(device);
+
+    if (!decompressor.open(QIODevice::ReadOnly))
+    {
+      _errorString = decompressor.errorString();
+      return false;
+    }
+
+    if (!reader.read(decompressor))
+    {
+      _errorString = reader.errorString();
+      return false;
+    }
+
+    if (decompressor.hasError())
+    {
+      _errorString = decompressor.errorString();
+      return false;
+    }
+
+    return true;
+  }
+
+  if (!reader.read(device))
+  {
+    _errorString = reader.errorString();
+    return false;
+  }
+
+  return true;
+}
+
+
+void
+DataFlowGraphModel::
+reconcile(QJsonDocument const & json)
+{
+  QJsonObject const jsonDocument = json.object();
+
+  QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+
+  std::vector<QJsonObject> nodesJson;
+  nodesJson.reserve(nodesJsonArray.size());
+
+  std::unordered_map<NodeId, std::size_t> nodeIndices;
+
+  for (QJsonValueRef node : nodesJsonArray)
+  {
+    nodesJson.push_back(node.toObject());
+
+    nodeIndices[static_cast<NodeId>(nodesJson.back()["id"].toInt())] =
+      nodesJson.size() - 1;
+  }
+
+  std::unordered_set<ConnectionId> connectionIds;
+
+  QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+
+  for (QJsonValueRef connection : connectionJsonArray)
+  {
+    connectionIds.insert(makeConnectionId(connection.toObject()));
+  }
+
+  Q_EMIT batchUpdateStarted();
+
+  _propagationSuspended = true;
+
+  std::unordered_set<std::pair<NodeId, PortIndex>> inPorts;
+  std::unordered_set<std::pair<NodeId, PortIndex>> outPorts;
+
+  auto remove =
+    [&](ConnectionId const & connectionId)
+    {
+      if (deleteConnection(connectionId))
+        inPorts.insert(std::make_pair(connectionId.inNodeId,
+                                      connectionId.inPortIndex));
+    };
+
+  auto drop =
+    [&](NodeId const nodeId)
+    {
+      for (auto const & connectionId : allConnectionIds(nodeId))
+      {
+        remove(connectionId);
+      }
+
+      deleteNode(nodeId);
+    };
+
+  std::vector<ConnectionId> staleConnections;
+
+  for (auto const & connPair : _connectivity)
+  {
+    ConnectivityKey const & key = connPair.first;
+
+    if (std::get<1>(key) != PortType::Out)
+      continue;
+
+    for (auto const & otherSide : connPair.second)
+    {
+      ConnectionId const connId{std::get<0>(key),
+                                std::get<2>(key),
+                                otherSide.first,
+                                otherSide.second};
+
+      if (connectionIds.count(connId) == 0)
+        staleConnections.push_back(connId);
+    }
+  }
+
+  for (auto const & connectionId : staleConnections)
+  {
+    remove(connectionId);
+  }
+
+  for (NodeId const nodeId : allNodeIds())
+  {
+    auto indexIt = nodeIndices.find(nodeId);
+
+    if (indexIt == nodeIndices.end())
+    {
+      drop(nodeId);
+      continue;
+    }
+
+    QJsonObject const & nodeJson = nodesJson[indexIt->second];
+
+    QJsonObject const internalData = nodeJson["internal-data"].toObject();
+
+    if (descriptor(nodeId)->name() != internalData["model-name"].toString())
+    {
+      // Recreated below, with the nodes missing from the model.
+      drop(nodeId);
+      continue;
+    }
+
+    QJsonObject posJson = nodeJson["position"].toObject();
+    QPointF const pos(posJson["x"].toDouble(),
+                      posJson["y"].toDouble());
+
+    if (_nodeGeometryData[nodeId].pos != pos)
+      setNodeData(nodeId, NodeRole::Position, pos);
+
+    auto lazyIt = _lazyNodes.find(nodeId);
+
+    if (lazyIt != _lazyNodes.end())
+    {
+      if (lazyIt->second.internalData != internalData)
+      {
+        lazyIt->second.internalData = internalData;
+
+        markNodeDirty(nodeId);
+      }
+
+      continue;
+    }
+
+    NodeDelegateModel * model = _models.at(nodeId).get();
+
+    if (model->save() == internalData)
+      continue;
+
+    unsigned int const nInPorts = model->nPorts(PortType::In);
+    unsigned int const nOutPorts = model->nPorts(PortType::Out);
+
+    model->load(internalData);
+
+    markNodeDirty(nodeId);
+
+    // The attached connections would refer to ports which no longer
+    // exist, the node is recreated instead.
+    if (model->nPorts(PortType::In) != nInPorts ||
+        model->nPorts(PortType::Out) != nOutPorts)
+    {
+      drop(nodeId);
+      continue;
+    }
+
+    for (PortIndex portIndex = 0; portIndex < nOutPorts; ++portIndex)
+    {
+      outPorts.insert(std::make_pair(nodeId, portIndex));
+    }
+
+    Q_EMIT nodeUpdated(nodeId);
+  }
+
+  std::vector<QJsonObject> newNodesJson;
+
+  for (auto const & nodeJson : nodesJson)
+  {
+    if (!nodeExists(static_cast<NodeId>(nodeJson["id"].toInt())))
+      newNodesJson.push_back(nodeJson);
+  }
+
+  loadNodes(newNodesJson);
+
+  for (auto const & connectionId : connectionIds)
+  {
+    if (connectionExists(connectionId) ||
+        !nodeExists(connectionId.outNodeId) ||
+        !nodeExists(connectionId.inNodeId))
+      continue;
+
+    addConnection(connectionId);
+
+    outPorts.insert(std::make_pair(connectionId.outNodeId,
+                                   connectionId.outPortIndex));
+  }
+
+  _propagationSuspended = false;
+
+  // Ports which got a new connection receive its data afterwards.
+  for (auto const & inPort : inPorts)
+  {
+    propagateEmptyDataTo(inPort.first, inPort.second);
+  }
+
+  for (auto const & outPort : outPorts)
+  {
+    onOutPortDataUpdated(outPort.first, outPort.second);
+  }
+
+  Q_EMIT batchUpdateFinished();
+}
+
+
+void
+DataFlowGraphModel::
+loadSubgraph(std::vector<QJsonObject> const &  nodesJson,
+             std::vector<ConnectionId> const & connectionIds)
+{
+  Q_EMIT batchUpdateStarted();
+
+  _propagationSuspended = true;
+
+  loadNodes(nodesJson);
+
+  std::unordered_set<std::pair<NodeId, PortIndex>> outPorts;
+
+  for (auto const & connectionId : connectionIds)
+  {
+    if (connectionExists(connectionId))
+      continue;
+
+    addConnection(connectionId);
+
+    outPorts.insert(std::make_pair(connectionId.outNodeId,
+                                   connectionId.outPortIndex));
+  }
+
+  _propagationSuspended = false;
+
+  for (auto const & outPort : outPorts)
+  {
+    onOutPortDataUpdated(outPort.first, outPort.second);
+  }
+
+  Q_EMIT batchUpdateFinished();
+}
+
+
+void
+DataFlowGraphModel::
+deleteSubgraph(std::vector<NodeId> const &       nodeIds,
+               std::vector<ConnectionId> const & connectionIds)
+{
+  Q_EMIT batchUpdateStarted();
+
+  _propagationSuspended = true;
+
+  std::unordered_set<std::pair<NodeId, PortIndex>> inPorts;
+
+  auto remove =
+    [&](ConnectionId const & connectionId)
+    {
+      if (deleteConnection(connectionId))
+        inPorts.insert(std::make_pair(connectionId.inNodeId,
+                                      connectionId.inPortIndex));
+    };
+
+  for (auto const & connectionId : connectionIds)
+  {
+    remove(connectionId);
+  }
+
+  for (NodeId const nodeId : nodeIds)
+  {
+    for (auto const & connectionId : allConnectionIds(nodeId))
+    {
+      remove(connectionId);
+    }
+
+    deleteNode(nodeId);
+  }
+
+  _propagationSuspended = false;
+
+  // The deleted nodes are skipped by `propagateEmptyDataTo`.
+  for (auto const & inPort : inPorts)
+  {
+    propagateEmptyDataTo(inPort.first, inPort.second);
+  }
+
+  Q_EMIT batchUpdateFinished();
+}
+
+
+QJsonObject
+DataFlowGraphModel::
+saveConnection(ConnectionId const & connId) const
+{
+  QJsonObject connJson;
+
+  connJson["outNodeId"] = static_cast<qint64>(connId.outNodeId);
+  connJson["outPortIndex"] = static_cast<qint64>(connId.outPortIndex);
+  connJson["intNodeId"] = static_cast<qint64>(connId.inNodeId);
+  connJson["inPortIndex"] = static_cast<qint64>(connId.inPortIndex);
+
+  return connJson;
+}
+
+
+void
+DataFlowGraphModel::
+loadConnection(QJsonObject const & connJson)
+{
+  addConnection(makeConnectionId(connJson));
+}
+
+
+void
+DataFlowGraphModel::
+onOutPortDataUpdated(NodeId const    nodeId,
+                     PortIndex const portIndex)
+{
+  // Placeholders pull their inputs when they are materialized.
+  if (_propagationSuspended || !isMaterialized(nodeId))
+    return;
+
+  std::unordered_set<ConnectionId> const& connected =
+    connections(nodeId, PortType::Out, portIndex);
+
+  QVariant const portDataToPropagate =
+    portData(nodeId, PortType::Out, portIndex, PortRole::Data);
+
+  for (auto const& cn : connected)
+  {
+    // When restoring a model from file, not all models are loaded simultaneously.
+    if (!isMaterialized(cn.inNodeId))
+      continue;
+
+    setPortData(cn.inNodeId, PortType::In,
+                cn.inPortIndex, portDataToPropagate,
+                PortRole::Data);
+
+    // Maybe this call should be on the receiving side.
+    Q_EMIT inPortDataWasSet(cn.inNodeId, PortType::In, cn.inPortIndex);
+  }
+}
+
+
+void
+DataFlowGraphModel::
+propagateEmptyDataTo(NodeId const    nodeId,
+                     PortIndex const portIndex)
+{
+  auto const emptyData = std::shared_ptr<NodeData>();
+
+  if (_propagationSuspended)
+    return;
 
   // When restoring a model from file, not all models are loaded simultaneously.
-  if (_models.find(nodeId) != _models.end())
+  if (isMaterialized(nodeId))
   {
     _models[nodeId]->setInData(emptyData, portIndex);
 
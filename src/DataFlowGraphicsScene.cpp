@@ -33,12 +33,19 @@ namespace QtNodes
 
 DataFlowGraphicsScene::
 DataFlowGraphicsScene(DataFlowGraphModel& graphModel,
-                      QObject*            parent)
-  : BasicGraphicsScene(graphModel, parent)
+                      QObject*            parent,
+                      PopulationMode      populationMode)
+  : BasicGraphicsScene(graphModel, parent, populationMode)
   , _graphModel(graphModel)
+  , _compression(GraphCompression::None)
 {
   connect(&_graphModel, &AbstractGraphModel::inPortDataWasSet,
           this, &DataFlowGraphicsScene::onPortDataSet);
+
+  // A lazily loaded node gets its delegate model, and its embedded
+  // widget, once the user picks it.
+  connect(this, &BasicGraphicsScene::nodeSelected,
+          &_graphModel, &DataFlowGraphModel::materializeNode);
 }
 
 
@@ -165,9 +172,9 @@ save() const
       fileName += ".flow";
 
     QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly))
+    if (!file.open(QIODevice::WriteOnly) || !_graphModel.save(file, _compression))
     {
-      file.write(saveToJsonDocument().toJson());
+      qWarning() << "Failed to save" << fileName << ":" << file.errorString();
     }
   }
 }
@@ -193,9 +200,17 @@ load()
 
   clearScene();
 
-  QByteArray const wholeFile = file.readAll();
+  bool const loaded =
+    _graphModel.load(file,
+                     [this](qint64 bytesProcessed, qint64 bytesTotal)
+                     {
+                       Q_EMIT loadProgress(bytesProcessed, bytesTotal);
+                     });
 
-  loadFromJsonDocument(QJsonDocument::fromJson(wholeFile));
+  if (!loaded)
+  {
+    qWarning() << "Failed to load" << fileName << ":" << _graphModel.errorString();
+  }
 }
 
 
@@ -215,6 +230,14 @@ loadFromJsonDocument(QJsonDocument const & json)
 }
 
 
+void
+DataFlowGraphicsScene::
+reconcileWithJsonDocument(QJsonDocument const & json)
+{
+  _graphModel.reconcile(json);
+}
+
+
 
 void
 DataFlowGraphicsScene::
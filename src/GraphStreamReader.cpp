@@ -0,0 +1,297 @@
+#include "GraphStreamReader.hpp"
+
+#include "AbstractGraphModel.hpp"
+
+#include <QtCore/QIODevice>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonParseError>
+
+#include <algorithm>
+#include <utility>
+
+
+namespace QtNodes
+{
+
+GraphStreamReader::
+GraphStreamReader(AbstractGraphModel &graphModel)
+  : _graphModel(graphModel)
+  , _chunkSize(64 * 1024)
+  , _batchSize(256)
+  , _nodeCount(0)
+  , _connectionCount(0)
+  , _depth(0)
+  , _inString(false)
+  , _escaped(false)
+  , _nodesDone(false)
+  , _section(Section::None)
+{}
+
+
+void
+GraphStreamReader::
+setProgressCallback(ProgressCallback callback)
+{
+  _progressCallback = std::move(callback);
+}
+
+
+void
+GraphStreamReader::
+setChunkSize(qint64 chunkSize)
+{
+  _chunkSize = std::max<qint64>(chunkSize, 1);
+}
+
+
+void
+GraphStreamReader::
+setBatchSize(std::size_t batchSize)
+{
+  _batchSize = std::max<std::size_t>(batchSize, 1);
+}
+
+
+bool
+GraphStreamReader::
+read(QIODevice &device)
+{
+  reset();
+
+  qint64 const bytesTotal = device.isSequential() ? -1 : device.size();
+  qint64 bytesProcessed = 0;
+
+  bool ok = true;
+
+  for (;;)
+  {
+    QByteArray const chunk = device.read(_chunkSize);
+
+    if (chunk.isEmpty())
+      break;
+
+    bytesProcessed += chunk.size();
+
+    ok = consume(chunk.constData(), chunk.size());
+
+    if (_progressCallback)
+      _progressCallback(bytesProcessed, bytesTotal);
+
+    if (!ok)
+      break;
+  }
+
+  if (ok && (bytesProcessed == 0 || _depth != 0))
+  {
+    _errorString = QStringLiteral("Unexpected end of graph data");
+    ok = false;
+  }
+
+  flushNodeBatch();
+
+  // Connections are restored even if the file has no `nodes` array.
+  _nodesDone = true;
+  for (auto const & connJson : _deferredConnections)
+  {
+    applyConnection(connJson);
+  }
+  _deferredConnections.clear();
+
+  return ok;
+}
+
+
+void
+GraphStreamReader::
+reset()
+{
+  _errorString.clear();
+  _nodeCount = 0;
+  _connectionCount = 0;
+  _depth = 0;
+  _inString = false;
+  _escaped = false;
+  _nodesDone = false;
+  _section = Section::None;
+  _lastKey.clear();
+  _record.clear();
+  _nodeBatch.clear();
+  _deferredConnections.clear();
+}
+
+
+bool
+GraphStreamReader::
+consume(char const * data, qint64 size)
+{
+  bool const recordingSection =
+    (_section == Section::Nodes || _section == Section::Connections);
+
+  // A record started in one of the previous chunks continues from the
+  // very first byte of this one.
+  qint64 recordStart = (recordingSection && _depth >= 3) ? 0 : -1;
+
+  for (qint64 i = 0; i < size; ++i)
+  {
+    char const c = data[i];
+
+    if (_inString)
+    {
+      if (_escaped)
+        _escaped = false;
+      else if (c == '\\')
+        _escaped = true;
+      else if (c == '"')
+        _inString = false;
+      else if (_depth == 1)
+        _lastKey.append(c);
+
+      continue;
+    }
+
+    switch (c)
+    {
+      case '"':
+        _inString = true;
+        if (_depth == 1)
+          _lastKey.clear();
+        break;
+
+      case '{':
+      case '[':
+        if (_depth == 0 && c != '{')
+        {
+          _errorString = QStringLiteral("Graph data must be a JSON object");
+          return false;
+        }
+
+        if (_depth == 1)
+        {
+          if (c == '[' && _lastKey == "nodes")
+            _section = Section::Nodes;
+          else if (c == '[' && _lastKey == "connections")
+            _section = Section::Connections;
+          else
+            _section = Section::Skipped;
+        }
+        else if (_depth == 2 && c == '{' &&
+                 (_section == Section::Nodes ||
+                  _section == Section::Connections))
+        {
+          _record.clear();
+          recordStart = i;
+        }
+
+        ++_depth;
+        break;
+
+      case '}':
+      case ']':
+        if (--_depth < 0)
+        {
+          _errorString = QStringLiteral("Unbalanced graph data");
+          return false;
+        }
+
+        if (_depth == 2 && c == '}' && recordStart >= 0)
+        {
+          _record.append(data + recordStart, i - recordStart + 1);
+          recordStart = -1;
+
+          if (!finishRecord())
+            return false;
+        }
+        else if (_depth == 1)
+        {
+          if (_section == Section::Nodes)
+          {
+            flushNodeBatch();
+
+            _nodesDone = true;
+
+            for (auto const & connJson : _deferredConnections)
+            {
+              applyConnection(connJson);
+            }
+            _deferredConnections.clear();
+          }
+
+          _section = Section::None;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (recordStart >= 0)
+  {
+    _record.append(data + recordStart, size - recordStart);
+  }
+
+  return true;
+}
+
+
+bool
+GraphStreamReader::
+finishRecord()
+{
+  QJsonParseError error;
+
+  QJsonDocument const doc = QJsonDocument::fromJson(_record, &error);
+
+  _record.clear();
+
+  if (error.error != QJsonParseError::NoError || !doc.isObject())
+  {
+    _errorString = error.errorString();
+    return false;
+  }
+
+  if (_section == Section::Nodes)
+  {
+    _nodeBatch.push_back(doc.object());
+    ++_nodeCount;
+
+    if (_nodeBatch.size() >= _batchSize)
+      flushNodeBatch();
+  }
+  else
+  {
+    applyConnection(doc.object());
+  }
+
+  return true;
+}
+
+
+void
+GraphStreamReader::
+applyConnection(QJsonObject const & connJson)
+{
+  if (!_nodesDone)
+  {
+    _deferredConnections.push_back(connJson);
+    return;
+  }
+
+  _graphModel.loadConnection(connJson);
+  ++_connectionCount;
+}
+
+
+void
+GraphStreamReader::
+flushNodeBatch()
+{
+  if (_nodeBatch.empty())
+    return;
+
+  _graphModel.loadNodes(_nodeBatch);
+  _nodeBatch.clear();
+}
+
+
+}
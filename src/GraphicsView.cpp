@@ -31,6 +31,7 @@ GraphicsView(QWidget *parent)
   : QGraphicsView(parent)
   , _clearSelectionAction(Q_NULLPTR)
   , _deleteSelectionAction(Q_NULLPTR)
+  , _rubberBand(Q_NULLPTR)
 {
   setDragMode(QGraphicsView::ScrollHandDrag);
   setRenderHint(QPainter::Antialiasing);
@@ -135,6 +136,8 @@ centerScene()
     }
 
     centerOn(sceneRect.center());
+
+    reportVisibleRect();
   }
 }
 
@@ -196,6 +199,8 @@ scaleUp()
     return;
 
   scale(factor, factor);
+
+  reportVisibleRect();
 }
 
 
@@ -207,6 +212,8 @@ scaleDown()
   double const factor = std::pow(step, -1.0);
 
   scale(factor, factor);
+
+  reportVisibleRect();
 }
 
 
@@ -224,8 +231,10 @@ keyPressEvent(QKeyEvent *event)
 {
   switch (event->key())
   {
+    // The view draws the rubber band itself, QGraphicsView's own band
+    // would select through a scan of all the items.
     case Qt::Key_Shift:
-      setDragMode(QGraphicsView::RubberBandDrag);
+      setDragMode(QGraphicsView::NoDrag);
       break;
 
     default:
@@ -261,6 +270,19 @@ mousePressEvent(QMouseEvent *event)
   if (event->button() == Qt::LeftButton)
   {
     _clickPos = mapToScene(event->pos());
+
+    // Shift-drag on the empty canvas.
+    if ((event->modifiers() & Qt::ShiftModifier) &&
+        scene()->mouseGrabberItem() == nullptr &&
+        nodeScene())
+    {
+      if (!_rubberBand)
+        _rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
+
+      _rubberBandOrigin = event->pos();
+      _rubberBand->setGeometry(QRect(_rubberBandOrigin, QSize()));
+      _rubberBand->show();
+    }
   }
 }
 
@@ -269,6 +291,19 @@ void
 GraphicsView::
 mouseMoveEvent(QMouseEvent *event)
 {
+  if (_rubberBand && _rubberBand->isVisible())
+  {
+    QRect const band = QRect(_rubberBandOrigin, event->pos()).normalized();
+
+    _rubberBand->setGeometry(band);
+
+    nodeScene()->setSelectionRect(mapToScene(band).boundingRect(),
+                                  (event->modifiers() & Qt::ControlModifier) ?
+                                  Qt::AddToSelection :
+                                  Qt::ReplaceSelection);
+    return;
+  }
+
   QGraphicsView::mouseMoveEvent(event);
   if (scene()->mouseGrabberItem() == nullptr && event->buttons() == Qt::LeftButton)
   {
@@ -277,11 +312,24 @@ mouseMoveEvent(QMouseEvent *event)
     {
       QPointF difference = _clickPos - mapToScene(event->pos());
       setSceneRect(sceneRect().translated(difference.x(), difference.y()));
+
+      reportVisibleRect();
     }
   }
 }
 
 
+void
+GraphicsView::
+mouseReleaseEvent(QMouseEvent *event)
+{
+  if (event->button() == Qt::LeftButton && _rubberBand)
+    _rubberBand->hide();
+
+  QGraphicsView::mouseReleaseEvent(event);
+}
+
+
 void
 GraphicsView::
 drawBackground(QPainter* painter, const QRectF &r)
@@ -349,9 +397,40 @@ showEvent(QShowEvent *event)
 }
 
 
+void
+GraphicsView::
+resizeEvent(QResizeEvent *event)
+{
+  QGraphicsView::resizeEvent(event);
+
+  reportVisibleRect();
+}
+
+
+void
+GraphicsView::
+scrollContentsBy(int dx, int dy)
+{
+  QGraphicsView::scrollContentsBy(dx, dy);
+
+  reportVisibleRect();
+}
+
+
 BasicGraphicsScene *
 GraphicsView::
 nodeScene()
 {
   return dynamic_cast<BasicGraphicsScene*>(scene());
 }
+
+
+void
+GraphicsView::
+reportVisibleRect()
+{
+  if (auto s = nodeScene())
+  {
+    s->setVisibleRect(mapToScene(viewport()->rect()).boundingRect());
+  }
+}
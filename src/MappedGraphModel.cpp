@@ -0,0 +1,985 @@
+#include "MappedGraphModel.hpp"
+
+#include "NodeData.hpp"
+#include "StyleCollection.hpp"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+#include <QtWidgets/QWidget>
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+namespace
+{
+
+quint32 const FileMagic   = 0x4d474e51; // "QNGM"
+quint32 const FileVersion = 2;
+
+enum NodeRecordFlag : quint32
+{
+  CaptionVisibleFlag = 0x1,
+  ResizableFlag      = 0x2,
+};
+
+/// Size prefixed bytes of a port entry, clamped to the end of the entries.
+/**
+ * The bytes are not copied, they stay valid while the file is mapped.
+ */
+QByteArray
+readSized(char const *& p, char const * end)
+{
+  quint32 size = 0;
+  if (end - p < static_cast<qptrdiff>(sizeof(size)))
+  {
+    p = end;
+    return QByteArray();
+  }
+
+  std::memcpy(&size, p, sizeof(size));
+  p += sizeof(size);
+
+  size = std::min<quint32>(size, static_cast<quint32>(end - p));
+  QByteArray const bytes = QByteArray::fromRawData(p, static_cast<int>(size));
+  p += size;
+
+  return bytes;
+}
+
+
+/// Whether `count` records from `first` lie within a table of `total`.
+bool
+rangeFits(quint32 first, quint32 count, quint32 total)
+{
+  return quint64(first) + count <= total;
+}
+
+}
+
+
+struct MappedGraphModel::PoolRef
+{
+  quint64 offset;
+  quint64 size;
+};
+
+
+struct MappedGraphModel::FileHeader
+{
+  quint32 magic;
+  quint32 version;
+  quint32 nodeCount;
+  quint32 connectionCount;
+
+  quint64 nodeTableOffset;
+  quint64 connectionTableOffset;
+  quint64 inIndexOffset;
+  quint64 poolOffset;
+  quint64 poolSize;
+};
+
+
+struct MappedGraphModel::NodeRecord
+{
+  quint32 id;
+  quint32 flags;
+  quint32 nInPorts;
+  quint32 nOutPorts;
+
+  double x;
+  double y;
+
+  // Range in the connection table.
+  quint32 firstOutConnection;
+  quint32 outConnectionCount;
+
+  // Range in the in-node index of the connection table.
+  quint32 firstInConnection;
+  quint32 inConnectionCount;
+
+  PoolRef type;
+  PoolRef caption;
+  PoolRef internalData;
+
+  /// Offsets of the port entries, In ports first, then the entries.
+  /**
+   * The offsets are `quint32` relative to the start of the bytes, one
+   * per port, so that any entry is found without walking the others.
+   */
+  PoolRef ports;
+};
+
+
+struct MappedGraphModel::ConnectionRecord
+{
+  quint32 outNodeId;
+  quint32 outPortIndex;
+  quint32 inNodeId;
+  quint32 inPortIndex;
+};
+
+
+MappedGraphModel::
+MappedGraphModel()
+  : _data(nullptr)
+  , _size(0)
+  , _header(nullptr)
+{}
+
+
+MappedGraphModel::
+~MappedGraphModel()
+{
+  close();
+}
+
+
+bool
+MappedGraphModel::
+open(QString const & fileName)
+{
+  close();
+
+  _file.setFileName(fileName);
+
+  if (!_file.open(QIODevice::ReadOnly))
+  {
+    _errorString = _file.errorString();
+    return false;
+  }
+
+  _size = _file.size();
+
+  if (_size < static_cast<qint64>(sizeof(FileHeader)))
+  {
+    _errorString = QStringLiteral("File is too small");
+    close();
+    return false;
+  }
+
+  _data = _file.map(0, _size);
+
+  if (!_data)
+  {
+    _errorString = _file.errorString();
+    close();
+    return false;
+  }
+
+  _header = reinterpret_cast<FileHeader const *>(_data);
+
+  auto fits =
+    [this](quint64 offset, quint64 bytes)
+    {
+      return offset <= static_cast<quint64>(_size) &&
+             bytes <= static_cast<quint64>(_size) - offset;
+    };
+
+  bool const valid =
+    _header->magic == FileMagic &&
+    _header->version == FileVersion &&
+    fits(_header->nodeTableOffset,
+         quint64(_header->nodeCount) * sizeof(NodeRecord)) &&
+    fits(_header->connectionTableOffset,
+         quint64(_header->connectionCount) * sizeof(ConnectionRecord)) &&
+    fits(_header->inIndexOffset,
+         quint64(_header->connectionCount) * sizeof(quint32)) &&
+    fits(_header->poolOffset, _header->poolSize);
+
+  if (!valid)
+  {
+    _errorString = QStringLiteral("Not a mapped graph file");
+    close();
+    return false;
+  }
+
+  _errorString.clear();
+
+  return true;
+}
+
+
+void
+MappedGraphModel::
+close()
+{
+  if (_data)
+  {
+    _file.unmap(const_cast<uchar *>(_data));
+  }
+
+  _file.close();
+
+  _data = nullptr;
+  _size = 0;
+  _header = nullptr;
+
+  _positions.clear();
+  _sizes.clear();
+}
+
+
+bool
+MappedGraphModel::
+write(AbstractGraphModel const & graphModel,
+      QString const & fileName)
+{
+  // Tables are written back to back, records must keep 8-byte alignment
+  // of the doubles inside the mapping.
+  static_assert(sizeof(FileHeader) % 8 == 0, "Unexpected FileHeader layout");
+  static_assert(sizeof(NodeRecord) % 8 == 0, "Unexpected NodeRecord layout");
+
+  auto const allIds = graphModel.allNodeIds();
+
+  std::vector<NodeId> nodeIds(allIds.begin(), allIds.end());
+  std::sort(nodeIds.begin(), nodeIds.end());
+
+  QByteArray pool;
+
+  auto appendToPool =
+    [&pool](QByteArray const & bytes)
+    {
+      PoolRef ref{static_cast<quint64>(pool.size()),
+                  static_cast<quint64>(bytes.size())};
+      pool.append(bytes);
+      return ref;
+    };
+
+  auto appendSized =
+    [](QByteArray & target, QByteArray const & bytes)
+    {
+      quint32 const size = static_cast<quint32>(bytes.size());
+      target.append(reinterpret_cast<char const *>(&size), sizeof(size));
+      target.append(bytes);
+    };
+
+  std::vector<ConnectionRecord> connectionTable;
+  std::vector<NodeRecord> nodeTable;
+  nodeTable.reserve(nodeIds.size());
+
+  for (NodeId const nodeId : nodeIds)
+  {
+    NodeRecord record;
+    std::memset(&record, 0, sizeof(record));
+
+    record.id = nodeId;
+
+    if (graphModel.nodeData(nodeId, NodeRole::CaptionVisible).toBool())
+      record.flags |= CaptionVisibleFlag;
+
+    if (graphModel.nodeFlags(nodeId) & NodeFlag::Resizable)
+      record.flags |= ResizableFlag;
+
+    record.nInPorts =
+      graphModel.nodeData(nodeId, NodeRole::NumberOfInPorts).toUInt();
+    record.nOutPorts =
+      graphModel.nodeData(nodeId, NodeRole::NumberOfOutPorts).toUInt();
+
+    QPointF const pos =
+      graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+    record.x = pos.x();
+    record.y = pos.y();
+
+    record.type =
+      appendToPool(graphModel.nodeData(nodeId, NodeRole::Type).toString().toUtf8());
+    record.caption =
+      appendToPool(graphModel.nodeData(nodeId, NodeRole::Caption).toString().toUtf8());
+
+    QJsonObject const internalData =
+      graphModel.saveNode(nodeId)["internal-data"].toObject();
+    record.internalData =
+      appendToPool(QJsonDocument(internalData).toJson(QJsonDocument::Compact));
+
+    quint32 const offsetTableSize =
+      (record.nInPorts + record.nOutPorts) * sizeof(quint32);
+
+    QByteArray portOffsets;
+    QByteArray ports;
+
+    for (PortType portType : {PortType::In, PortType::Out})
+    {
+      unsigned int const n =
+        (portType == PortType::In) ? record.nInPorts : record.nOutPorts;
+
+      for (PortIndex portIndex = 0; portIndex < n; ++portIndex)
+      {
+        quint32 const offset = offsetTableSize + static_cast<quint32>(ports.size());
+        portOffsets.append(reinterpret_cast<char const *>(&offset), sizeof(offset));
+
+        auto const dataType =
+          graphModel.portData(nodeId, portType, portIndex,
+                              PortRole::DataType).value<NodeDataType>();
+
+        auto const policy =
+          graphModel.portData(nodeId, portType, portIndex,
+                              PortRole::ConnectionPolicyRole).value<ConnectionPolicy>();
+
+        bool const captionVisible =
+          graphModel.portData(nodeId, portType, portIndex,
+                              PortRole::CaptionVisible).toBool();
+
+        ports.append(static_cast<char>(captionVisible));
+        ports.append(static_cast<char>(policy));
+
+        appendSized(ports,
+                    graphModel.portData(nodeId, portType, portIndex,
+                                        PortRole::Caption).toString().toUtf8());
+        appendSized(ports, dataType.id.toUtf8());
+        appendSized(ports, dataType.name.toUtf8());
+      }
+
+      if (portType == PortType::Out)
+      {
+        record.firstOutConnection =
+          static_cast<quint32>(connectionTable.size());
+
+        for (PortIndex portIndex = 0; portIndex < n; ++portIndex)
+        {
+          auto const connected =
+            graphModel.connections(nodeId, PortType::Out, portIndex);
+
+          std::vector<ConnectionId> sorted(connected.begin(), connected.end());
+          std::sort(sorted.begin(), sorted.end(),
+                    [](ConnectionId const & a, ConnectionId const & b)
+                    {
+                      return std::tie(a.inNodeId, a.inPortIndex) <
+                             std::tie(b.inNodeId, b.inPortIndex);
+                    });
+
+          for (auto const & cn : sorted)
+          {
+            connectionTable.push_back(ConnectionRecord{cn.outNodeId,
+                                                       cn.outPortIndex,
+                                                       cn.inNodeId,
+                                                       cn.inPortIndex});
+          }
+        }
+
+        record.outConnectionCount =
+          static_cast<quint32>(connectionTable.size()) - record.firstOutConnection;
+      }
+    }
+
+    record.ports = appendToPool(portOffsets + ports);
+
+    nodeTable.push_back(record);
+  }
+
+  // Index of the connection table ordered by the in-node.
+  std::vector<quint32> inIndex(connectionTable.size());
+  for (quint32 i = 0; i < inIndex.size(); ++i)
+    inIndex[i] = i;
+
+  std::stable_sort(inIndex.begin(), inIndex.end(),
+                   [&connectionTable](quint32 a, quint32 b)
+                   {
+                     return std::tie(connectionTable[a].inNodeId,
+                                     connectionTable[a].inPortIndex) <
+                            std::tie(connectionTable[b].inNodeId,
+                                     connectionTable[b].inPortIndex);
+                   });
+
+  {
+    std::size_t i = 0;
+    for (auto & record : nodeTable)
+    {
+      while (i < inIndex.size() &&
+             connectionTable[inIndex[i]].inNodeId < record.id)
+        ++i;
+
+      record.firstInConnection = static_cast<quint32>(i);
+
+      while (i < inIndex.size() &&
+             connectionTable[inIndex[i]].inNodeId == record.id)
+        ++i;
+
+      record.inConnectionCount =
+        static_cast<quint32>(i) - record.firstInConnection;
+    }
+  }
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+
+  header.magic = FileMagic;
+  header.version = FileVersion;
+  header.nodeCount = static_cast<quint32>(nodeTable.size());
+  header.connectionCount = static_cast<quint32>(connectionTable.size());
+
+  header.nodeTableOffset = sizeof(FileHeader);
+  header.connectionTableOffset =
+    header.nodeTableOffset + nodeTable.size() * sizeof(NodeRecord);
+  header.inIndexOffset =
+    header.connectionTableOffset + connectionTable.size() * sizeof(ConnectionRecord);
+  header.poolOffset =
+    header.inIndexOffset + inIndex.size() * sizeof(quint32);
+  header.poolSize = static_cast<quint64>(pool.size());
+
+  QSaveFile file(fileName);
+
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+  file.write(reinterpret_cast<char const *>(nodeTable.data()),
+             nodeTable.size() * sizeof(NodeRecord));
+  file.write(reinterpret_cast<char const *>(connectionTable.data()),
+             connectionTable.size() * sizeof(ConnectionRecord));
+  file.write(reinterpret_cast<char const *>(inIndex.data()),
+             inIndex.size() * sizeof(quint32));
+  file.write(pool);
+
+  return file.commit();
+}
+
+
+std::unordered_set<NodeId>
+MappedGraphModel::
+allNodeIds() const
+{
+  std::unordered_set<NodeId> nodeIds;
+
+  if (!_header)
+    return nodeIds;
+
+  nodeIds.reserve(_header->nodeCount);
+
+  NodeRecord const * table = nodeTable();
+  for (quint32 i = 0; i < _header->nodeCount; ++i)
+  {
+    nodeIds.insert(table[i].id);
+  }
+
+  return nodeIds;
+}
+
+
+std::unordered_set<ConnectionId>
+MappedGraphModel::
+allConnectionIds(NodeId const nodeId) const
+{
+  std::unordered_set<ConnectionId> result;
+
+  NodeRecord const * node = findNode(nodeId);
+  if (!node)
+    return result;
+
+  auto toConnectionId =
+    [](ConnectionRecord const & c)
+    {
+      return ConnectionId{c.outNodeId, c.outPortIndex,
+                          c.inNodeId, c.inPortIndex};
+    };
+
+  ConnectionRecord const * table = connectionTable();
+  quint32 const connectionCount = _header->connectionCount;
+
+  // Ranges and indices are checked on access, so that a corrupt file
+  // can't make the model read outside of the mapping.
+  if (rangeFits(node->firstOutConnection, node->outConnectionCount, connectionCount))
+  {
+    for (quint32 i = 0; i < node->outConnectionCount; ++i)
+    {
+      result.insert(toConnectionId(table[node->firstOutConnection + i]));
+    }
+  }
+
+  quint32 const * inIndex = inConnectionIndex();
+
+  if (rangeFits(node->firstInConnection, node->inConnectionCount, connectionCount))
+  {
+    for (quint32 i = 0; i < node->inConnectionCount; ++i)
+    {
+      quint32 const k = inIndex[node->firstInConnection + i];
+
+      if (k < connectionCount)
+        result.insert(toConnectionId(table[k]));
+    }
+  }
+
+  return result;
+}
+
+
+std::unordered_set<ConnectionId>
+MappedGraphModel::
+connections(NodeId    nodeId,
+            PortType  portType,
+            PortIndex portIndex) const
+{
+  std::unordered_set<ConnectionId> result;
+
+  NodeRecord const * node = findNode(nodeId);
+  if (!node)
+    return result;
+
+  ConnectionRecord const * table = connectionTable();
+  quint32 const connectionCount = _header->connectionCount;
+
+  if (portType == PortType::Out &&
+      rangeFits(node->firstOutConnection, node->outConnectionCount, connectionCount))
+  {
+    for (quint32 i = 0; i < node->outConnectionCount; ++i)
+    {
+      auto const & c = table[node->firstOutConnection + i];
+
+      if (c.outPortIndex == portIndex)
+        result.insert(ConnectionId{c.outNodeId, c.outPortIndex,
+                                   c.inNodeId, c.inPortIndex});
+    }
+  }
+  else if (portType == PortType::In &&
+           rangeFits(node->firstInConnection, node->inConnectionCount, connectionCount))
+  {
+    quint32 const * inIndex = inConnectionIndex();
+
+    for (quint32 i = 0; i < node->inConnectionCount; ++i)
+    {
+      quint32 const k = inIndex[node->firstInConnection + i];
+
+      if (k >= connectionCount)
+        continue;
+
+      auto const & c = table[k];
+
+      if (c.inPortIndex == portIndex)
+        result.insert(ConnectionId{c.outNodeId, c.outPortIndex,
+                                   c.inNodeId, c.inPortIndex});
+    }
+  }
+
+  return result;
+}
+
+
+bool
+MappedGraphModel::
+connectionExists(ConnectionId const connectionId) const
+{
+  auto const connected =
+    connections(connectionId.outNodeId,
+                PortType::Out,
+                connectionId.outPortIndex);
+
+  return connected.find(connectionId) != connected.end();
+}
+
+
+NodeId
+MappedGraphModel::
+addNode(QString const nodeType)
+{
+  Q_UNUSED(nodeType);
+
+  return InvalidNodeId;
+}
+
+
+bool
+MappedGraphModel::
+connectionPossible(ConnectionId const connectionId) const
+{
+  Q_UNUSED(connectionId);
+
+  return false;
+}
+
+
+void
+MappedGraphModel::
+addConnection(ConnectionId const connectionId)
+{
+  Q_UNUSED(connectionId);
+}
+
+
+bool
+MappedGraphModel::
+nodeExists(NodeId const nodeId) const
+{
+  return findNode(nodeId) != nullptr;
+}
+
+
+QVariant
+MappedGraphModel::
+nodeData(NodeId nodeId, NodeRole role) const
+{
+  QVariant result;
+
+  NodeRecord const * node = findNode(nodeId);
+  if (!node)
+    return result;
+
+  switch (role)
+  {
+    case NodeRole::Type:
+      result = poolString(node->type);
+      break;
+
+    case NodeRole::Position:
+    {
+      auto it = _positions.find(nodeId);
+      result = (it != _positions.end()) ?
+               it->second :
+               QPointF(node->x, node->y);
+    }
+    break;
+
+    case NodeRole::Size:
+    {
+      auto it = _sizes.find(nodeId);
+      result = (it != _sizes.end()) ? it->second : QSize();
+    }
+    break;
+
+    case NodeRole::CaptionVisible:
+      result = static_cast<bool>(node->flags & CaptionVisibleFlag);
+      break;
+
+    case NodeRole::Caption:
+      result = poolString(node->caption);
+      break;
+
+    case NodeRole::Style:
+    {
+      auto style = StyleCollection::nodeStyle();
+      result = style.toJson().toVariantMap();
+    }
+    break;
+
+    case NodeRole::StyleIndex:
+      result = 0;
+      break;
+
+    case NodeRole::InternalData:
+    {
+      QJsonObject nodeJson;
+
+      nodeJson["internal-data"] =
+        QJsonDocument::fromJson(poolBytes(node->internalData)).object();
+
+      result = nodeJson.toVariantMap();
+    }
+    break;
+
+    case NodeRole::NumberOfInPorts:
+      result = node->nInPorts;
+      break;
+
+    case NodeRole::NumberOfOutPorts:
+      result = node->nOutPorts;
+      break;
+
+    case NodeRole::Widget:
+      result = QVariant::fromValue(static_cast<QWidget *>(nullptr));
+      break;
+  }
+
+  return result;
+}
+
+
+NodeFlags
+MappedGraphModel::
+nodeFlags(NodeId nodeId) const
+{
+  NodeRecord const * node = findNode(nodeId);
+
+  if (node && (node->flags & ResizableFlag))
+    return NodeFlag::Resizable;
+
+  return NodeFlag::NoFlags;
+}
+
+
+bool
+MappedGraphModel::
+setNodeData(NodeId   nodeId,
+            NodeRole role,
+            QVariant value)
+{
+  if (!findNode(nodeId))
+    return false;
+
+  bool result = false;
+
+  switch (role)
+  {
+    case NodeRole::Position:
+    {
+      _positions[nodeId] = value.value<QPointF>();
+
+      Q_EMIT nodePositionUpdated(nodeId);
+
+      result = true;
+    }
+    break;
+
+    case NodeRole::Size:
+    {
+      _sizes[nodeId] = value.value<QSize>();
+      result = true;
+    }
+    break;
+
+    default:
+      break;
+  }
+
+  return result;
+}
+
+
+QVariant
+MappedGraphModel::
+portData(NodeId    nodeId,
+         PortType  portType,
+         PortIndex portIndex,
+         PortRole  role) const
+{
+  NodeRecord const * node = findNode(nodeId);
+  if (!node)
+    return QVariant();
+
+  return portEntry(*node, portType, portIndex, role);
+}
+
+
+bool
+MappedGraphModel::
+setPortData(NodeId          nodeId,
+            PortType        portType,
+            PortIndex       portIndex,
+            QVariant const& value,
+            PortRole        role)
+{
+  Q_UNUSED(nodeId);
+  Q_UNUSED(portType);
+  Q_UNUSED(portIndex);
+  Q_UNUSED(value);
+  Q_UNUSED(role);
+
+  return false;
+}
+
+
+bool
+MappedGraphModel::
+deleteConnection(ConnectionId const connectionId)
+{
+  Q_UNUSED(connectionId);
+
+  return false;
+}
+
+
+bool
+MappedGraphModel::
+deleteNode(NodeId const nodeId)
+{
+  Q_UNUSED(nodeId);
+
+  return false;
+}
+
+
+QJsonObject
+MappedGraphModel::
+saveNode(NodeId const nodeId) const
+{
+  QJsonObject nodeJson;
+
+  NodeRecord const * node = findNode(nodeId);
+  if (!node)
+    return nodeJson;
+
+  nodeJson["id"] = static_cast<qint64>(nodeId);
+
+  nodeJson["internal-data"] =
+    QJsonDocument::fromJson(poolBytes(node->internalData)).object();
+
+  {
+    QPointF const pos =
+      nodeData(nodeId, NodeRole::Position).value<QPointF>();
+
+    QJsonObject posJson;
+    posJson["x"] = pos.x();
+    posJson["y"] = pos.y();
+    nodeJson["position"] = posJson;
+  }
+
+  return nodeJson;
+}
+
+
+QJsonObject
+MappedGraphModel::
+saveConnection(ConnectionId const & connId) const
+{
+  QJsonObject connJson;
+
+  connJson["outNodeId"] = static_cast<qint64>(connId.outNodeId);
+  connJson["outPortIndex"] = static_cast<qint64>(connId.outPortIndex);
+  connJson["intNodeId"] = static_cast<qint64>(connId.inNodeId);
+  connJson["inPortIndex"] = static_cast<qint64>(connId.inPortIndex);
+
+  return connJson;
+}
+
+
+void
+MappedGraphModel::
+loadConnection(QJsonObject const & connJson)
+{
+  Q_UNUSED(connJson);
+}
+
+
+MappedGraphModel::NodeRecord const *
+MappedGraphModel::
+findNode(NodeId const nodeId) const
+{
+  if (!_header)
+    return nullptr;
+
+  NodeRecord const * begin = nodeTable();
+  NodeRecord const * end   = begin + _header->nodeCount;
+
+  NodeRecord const * it =
+    std::lower_bound(begin, end, nodeId,
+                     [](NodeRecord const & record, NodeId const id)
+                     {
+                       return record.id < id;
+                     });
+
+  if (it == end || it->id != nodeId)
+    return nullptr;
+
+  return it;
+}
+
+
+MappedGraphModel::NodeRecord const *
+MappedGraphModel::
+nodeTable() const
+{
+  return reinterpret_cast<NodeRecord const *>(_data + _header->nodeTableOffset);
+}
+
+
+MappedGraphModel::ConnectionRecord const *
+MappedGraphModel::
+connectionTable() const
+{
+  return reinterpret_cast<ConnectionRecord const *>(_data +
+                                                    _header->connectionTableOffset);
+}
+
+
+quint32 const *
+MappedGraphModel::
+inConnectionIndex() const
+{
+  return reinterpret_cast<quint32 const *>(_data + _header->inIndexOffset);
+}
+
+
+QByteArray
+MappedGraphModel::
+poolBytes(PoolRef const & ref) const
+{
+  if (ref.offset > _header->poolSize ||
+      ref.size > _header->poolSize - ref.offset)
+    return QByteArray();
+
+  // The pool is immutable while mapped, no need to copy the bytes.
+  return QByteArray::fromRawData(
+    reinterpret_cast<char const *>(_data + _header->poolOffset + ref.offset),
+    static_cast<int>(ref.size));
+}
+
+
+QString
+MappedGraphModel::
+poolString(PoolRef const & ref) const
+{
+  return QString::fromUtf8(poolBytes(ref));
+}
+
+
+QVariant
+MappedGraphModel::
+portEntry(NodeRecord const & node,
+          PortType           portType,
+          PortIndex          portIndex,
+          PortRole           role) const
+{
+  QVariant result;
+
+  unsigned int const nPorts =
+    (portType == PortType::In) ? node.nInPorts : node.nOutPorts;
+
+  if (portType == PortType::None || portIndex >= nPorts)
+    return result;
+
+  QByteArray const ports = poolBytes(node.ports);
+
+  // In ports are stored first.
+  quint64 const entry =
+    (portType == PortType::In) ? portIndex : quint64(node.nInPorts) + portIndex;
+
+  if ((entry + 1) * sizeof(quint32) > static_cast<quint64>(ports.size()))
+    return result;
+
+  quint32 offset = 0;
+  std::memcpy(&offset, ports.constData() + entry * sizeof(quint32), sizeof(offset));
+
+  if (quint64(offset) + 2 > static_cast<quint64>(ports.size()))
+    return result;
+
+  char const * p   = ports.constData() + offset;
+  char const * end = ports.constData() + ports.size();
+
+  bool const captionVisible = (p[0] != 0);
+  auto const policy = static_cast<ConnectionPolicy>(p[1]);
+  p += 2;
+
+  QByteArray const caption  = readSized(p, end);
+  QByteArray const typeId   = readSized(p, end);
+  QByteArray const typeName = readSized(p, end);
+
+  switch (role)
+  {
+    case PortRole::Data:
+      break;
+
+    case PortRole::DataType:
+      result = QVariant::fromValue(NodeDataType{QString::fromUtf8(typeId),
+                                                QString::fromUtf8(typeName)});
+      break;
+
+    case PortRole::ConnectionPolicyRole:
+      result = QVariant::fromValue(policy);
+      break;
+
+    case PortRole::CaptionVisible:
+      result = captionVisible;
+      break;
+
+    case PortRole::Caption:
+      result = QString::fromUtf8(caption);
+      break;
+  }
+
+  return result;
+}
+
+
+}
@@ -65,6 +65,17 @@ NodeDelegateModel::
 setNodeStyle(NodeStyle const& style)
 {
   _nodeStyle = style;
+  _nodeStyleHandle = StyleCollection::registerNodeStyle(style);
+
+  Q_EMIT nodeStyleChanged();
+}
+
+
+int
+NodeDelegateModel::
+nodeStyleHandle() const
+{
+  return _nodeStyleHandle;
 }
 
 
@@ -13,6 +13,8 @@
 #include "NodeConnectionInteraction.hpp"
 #include "NodeGeometry.hpp"
 #include "NodePainter.hpp"
+#include "NodePixmapCache.hpp"
+#include "NodeTextCache.hpp"
 #include "StyleCollection.hpp"
 #include "UndoCommands.hpp"
 
@@ -20,6 +22,15 @@
 namespace QtNodes
 {
 
+namespace
+{
+
+/// Next `stackingOrder()`, the nodes are created on the GUI thread.
+quint64 nextStackingOrder = 0;
+
+}
+
+
 NodeGraphicsObject::
 NodeGraphicsObject(BasicGraphicsScene& scene,
                    NodeId              nodeId)
@@ -27,6 +38,8 @@ NodeGraphicsObject(BasicGraphicsScene& scene,
   , _graphModel(scene.graphModel())
   , _nodeState(*this)
   , _proxyWidget(nullptr)
+  , _textCache(std::make_unique<NodeTextCache>())
+  , _stackingOrder(nextStackingOrder++)
 {
   scene.addItem(this);
 
@@ -36,7 +49,10 @@ NodeGraphicsObject(BasicGraphicsScene& scene,
   setFlag(QGraphicsItem::ItemIsSelectable,                     true);
   setFlag(QGraphicsItem::ItemSendsScenePositionChanges,        true);
 
-  setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+  // Nodes drawn from the scene's shared cache need no own image.
+  setCacheMode(scene.nodePixmapCache() ?
+               QGraphicsItem::NoCache :
+               QGraphicsItem::DeviceCoordinateCache);
 
 //  QJsonObject nodeStyleJson =
 //    _graphModel.nodeData(_nodeId, NodeRole::Style).toJsonObject();
@@ -73,6 +89,10 @@ NodeGraphicsObject(BasicGraphicsScene& scene,
 }
 
 
+NodeGraphicsObject::
+~NodeGraphicsObject() = default;
+
+
 AbstractGraphModel &
 NodeGraphicsObject::
 graphModel() const
@@ -93,6 +113,9 @@ void
 NodeGraphicsObject::
 embedQWidget()
 {
+  if (_proxyWidget)
+    return;
+
   NodeGeometry geom(*this);
 
   if (auto w = _graphModel.nodeData(_nodeId,
@@ -123,6 +146,22 @@ embedQWidget()
 }
 
 
+void
+NodeGraphicsObject::
+detachEmbeddedWidget()
+{
+  if (!_proxyWidget)
+    return;
+
+  if (QWidget * w = _proxyWidget->widget())
+  {
+    _proxyWidget->setWidget(nullptr);
+
+    w->hide();
+  }
+}
+
+
 #if 0
 void
 NodeGraphicsObject::
@@ -163,6 +202,9 @@ NodeGraphicsObject::
 setGeometryChanged()
 {
   prepareGeometryChange();
+
+  if (auto s = nodeScene())
+    s->invalidateNodeBounds(_nodeId);
 }
 
 
@@ -174,10 +216,7 @@ moveConnections() const
 
   for (auto& cnId : connected)
   {
-    auto cgo = nodeScene()->connectionGraphicsObject(cnId);
-
-    if (cgo)
-      cgo->move();
+    nodeScene()->updateConnectionGeometry(cnId);
   }
 }
 
@@ -230,7 +269,17 @@ paint(QPainter*                       painter,
 {
   painter->setClipRect(option->exposedRect);
 
-  NodePainter::paint(painter, *this);
+  qreal const lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+  BasicGraphicsScene * scene = nodeScene();
+
+  NodePixmapCache * cache = scene ? scene->nodePixmapCache() : nullptr;
+
+  // The ports react to a nearby draft connection, such frames are not shared.
+  if (cache && !_nodeState.connectionForReaction())
+    NodePainter::paintCached(painter, *this, lod, *cache);
+  else
+    NodePainter::paint(painter, *this, lod);
 }
 
 
@@ -240,7 +289,15 @@ itemChange(GraphicsItemChange change, const QVariant& value)
 {
   if (change == ItemScenePositionHasChanged && scene())
   {
-    moveConnections();
+    nodeScene()->invalidateNodeBounds(_nodeId);
+
+    // During a batch move the scene repositions the connections itself.
+    if (!nodeScene()->isTranslatingNodes())
+      moveConnections();
+  }
+  else if (change == ItemSelectedHasChanged && scene())
+  {
+    nodeScene()->recordNodeSelection(_nodeId, value.toBool());
   }
 
   return QGraphicsObject::itemChange(change, value);
@@ -274,13 +331,12 @@ mousePressEvent(QGraphicsSceneMouseEvent* event)
         auto const& cnId = *connected.begin();
 
         // Need ConnectionGraphicsObject
+        if (auto cgo = nodeScene()->promoteConnection(cnId))
+        {
+          NodeConnectionInteraction interaction(*this, *cgo, *nodeScene());
 
-        NodeConnectionInteraction
-          interaction(*this,
-                      *nodeScene()->connectionGraphicsObject(cnId),
-                      *nodeScene());
-
-        interaction.disconnect(portToCheck);
+          interaction.disconnect(portToCheck);
+        }
       }
       else // initialize new Connection
       {
@@ -330,6 +386,8 @@ mousePressEvent(QGraphicsSceneMouseEvent* event)
   if (otherButtons == Qt::NoButton)
   {
     _nodeState.setPressedPos(event->scenePos());
+
+    nodeScene()->beginNodeDrag();
   }
 
   QGraphicsObject::mousePressEvent(event);
@@ -379,6 +437,8 @@ mouseMoveEvent(QGraphicsSceneMouseEvent* event)
       // Passes the new size to the model.
       geometry.recalculateSize();
 
+      nodeScene()->invalidateNodeBounds(_nodeId);
+
       update();
 
       moveConnections();
@@ -390,9 +450,16 @@ mouseMoveEvent(QGraphicsSceneMouseEvent* event)
   {
     auto diff = event->pos() - event->lastPos();
 
-    nodeScene()->undoStack().push(new MoveNodeCommand(nodeScene(),
-                                                      _nodeId,
-                                                      diff));
+    // The whole selection follows the grabbed node.
+    auto const selected = nodeScene()->selectedNodes();
+
+    std::unordered_set<NodeId> nodeIds(selected.begin(), selected.end());
+    nodeIds.insert(_nodeId);
+
+    nodeScene()->undoStack().push(new MoveNodesCommand(nodeScene(),
+                                                       std::move(nodeIds),
+                                                       diff,
+                                                       nodeScene()->nodeDragGesture()));
 
     event->accept();
   }
@@ -437,14 +504,12 @@ void
 NodeGraphicsObject::
 hoverEnterEvent(QGraphicsSceneHoverEvent* event)
 {
-  // bring all the colliding nodes to background
-  QList<QGraphicsItem*> overlapItems = collidingItems();
-
-  for (QGraphicsItem* item : overlapItems)
+  // bring all the overlapping nodes to background
+  for (NodeGraphicsObject* node : nodeScene()->nodesIn(sceneBoundingRect()))
   {
-    if (item->zValue() > 0.0)
+    if (node != this && node->zValue() > 0.0)
     {
-      item->setZValue(0.0);
+      node->setZValue(0.0);
     }
   }
 
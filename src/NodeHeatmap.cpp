@@ -0,0 +1,331 @@
+#include "NodeHeatmap.hpp"
+
+#include "BasicGraphicsScene.hpp"
+
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+
+
+namespace QtNodes
+{
+
+constexpr int NodeHeatmap::LevelCount;
+
+
+NodeHeatmap::
+NodeHeatmap(BasicGraphicsScene & scene,
+            NodeId capacity,
+            QObject * parent)
+  : QObject(parent)
+  , _scene(scene)
+  , _capacity(capacity)
+  , _counters(new Counters[capacity])
+  , _end(0)
+  , _changed(false)
+  , _metric(Metric::ExecutionCount)
+  , _coloringConnections(false)
+  , _shown(false)
+{
+  setGradient(QColor(40, 110, 255, 150), QColor(255, 50, 20, 200));
+
+  _frameTimer.setInterval(16);
+
+  connect(&_frameTimer, &QTimer::timeout, this, &NodeHeatmap::refresh);
+}
+
+
+NodeHeatmap::
+~NodeHeatmap()
+{
+  // The scene must not keep drawing with a destroyed heatmap.
+  if (_shown)
+    hide();
+}
+
+
+bool
+NodeHeatmap::
+recordExecution(NodeId const nodeId, qint64 nsecs)
+{
+  if (nodeId >= _capacity)
+    return false;
+
+  Counters & counters = _counters[nodeId];
+
+  counters.count.fetch_add(1, std::memory_order_relaxed);
+  counters.totalTime.fetch_add(nsecs, std::memory_order_relaxed);
+  counters.lastLatency.store(nsecs, std::memory_order_relaxed);
+
+  NodeId end = _end.load(std::memory_order_relaxed);
+
+  while (end <= nodeId &&
+         !_end.compare_exchange_weak(end, nodeId + 1, std::memory_order_relaxed))
+  {}
+
+  _changed.store(true, std::memory_order_release);
+
+  return true;
+}
+
+
+void
+NodeHeatmap::
+reset()
+{
+  NodeId const end = _end.load(std::memory_order_acquire);
+
+  for (NodeId i = 0; i < end; ++i)
+  {
+    _counters[i].count.store(0, std::memory_order_relaxed);
+    _counters[i].totalTime.store(0, std::memory_order_relaxed);
+    _counters[i].lastLatency.store(0, std::memory_order_relaxed);
+  }
+
+  _changed.store(true, std::memory_order_release);
+}
+
+
+quint64
+NodeHeatmap::
+executionCount(NodeId const nodeId) const
+{
+  if (nodeId >= _capacity)
+    return 0;
+
+  return _counters[nodeId].count.load(std::memory_order_relaxed);
+}
+
+
+qint64
+NodeHeatmap::
+cumulativeTime(NodeId const nodeId) const
+{
+  if (nodeId >= _capacity)
+    return 0;
+
+  return _counters[nodeId].totalTime.load(std::memory_order_relaxed);
+}
+
+
+qint64
+NodeHeatmap::
+lastLatency(NodeId const nodeId) const
+{
+  if (nodeId >= _capacity)
+    return 0;
+
+  return _counters[nodeId].lastLatency.load(std::memory_order_relaxed);
+}
+
+
+void
+NodeHeatmap::
+setMetric(Metric metric)
+{
+  if (_metric == metric)
+    return;
+
+  _metric = metric;
+
+  _changed.store(true, std::memory_order_release);
+}
+
+
+void
+NodeHeatmap::
+setGradient(QColor const & cold, QColor const & hot)
+{
+  _colors.clear();
+  _colors.reserve(LevelCount);
+
+  for (int i = 0; i < LevelCount; ++i)
+  {
+    qreal const t = static_cast<qreal>(i) / (LevelCount - 1);
+
+    _colors.push_back(QColor::fromRgbF(cold.redF()   + t * (hot.redF()   - cold.redF()),
+                                       cold.greenF() + t * (hot.greenF() - cold.greenF()),
+                                       cold.blueF()  + t * (hot.blueF()  - cold.blueF()),
+                                       cold.alphaF() + t * (hot.alphaF() - cold.alphaF())));
+  }
+
+  if (!_shown)
+    return;
+
+  _scene.updateHeatLevels(levelledNodes(), _coloringConnections);
+}
+
+
+void
+NodeHeatmap::
+setColoringConnections(bool coloring)
+{
+  if (_coloringConnections == coloring)
+    return;
+
+  _coloringConnections = coloring;
+
+  if (!_shown)
+    return;
+
+  _scene.updateHeatLevels(levelledNodes(), true);
+}
+
+
+void
+NodeHeatmap::
+setFrameInterval(int msec)
+{
+  _frameTimer.setInterval(msec);
+}
+
+
+void
+NodeHeatmap::
+show()
+{
+  if (_shown)
+    return;
+
+  _shown = true;
+
+  _scene.setHeatmap(this);
+
+  invalidate();
+  refresh();
+
+  _frameTimer.start();
+}
+
+
+void
+NodeHeatmap::
+hide()
+{
+  if (!_shown)
+    return;
+
+  _frameTimer.stop();
+
+  _shown = false;
+
+  _scene.setHeatmap(nullptr);
+
+  _scene.updateHeatLevels(levelledNodes(), _coloringConnections);
+}
+
+
+int
+NodeHeatmap::
+level(NodeId const nodeId) const
+{
+  return (nodeId < _levels.size()) ? _levels[nodeId] : -1;
+}
+
+
+QColor
+NodeHeatmap::
+color(NodeId const nodeId) const
+{
+  int const l = level(nodeId);
+
+  return (l < 0) ? QColor() : _colors[l];
+}
+
+
+void
+NodeHeatmap::
+refresh()
+{
+  if (!_changed.exchange(false, std::memory_order_acquire))
+    return;
+
+  NodeId const end = _end.load(std::memory_order_acquire);
+
+  if (_levels.size() < end)
+    _levels.resize(end, -1);
+
+  // The levels are relative to the hottest node.
+  qint64 highest = 0;
+
+  for (NodeId i = 0; i < end; ++i)
+  {
+    if (_counters[i].count.load(std::memory_order_relaxed) > 0)
+      highest = std::max(highest, metricValue(_counters[i]));
+  }
+
+  std::vector<NodeId> changed;
+
+  for (NodeId i = 0; i < end; ++i)
+  {
+    int level = -1;
+
+    if (_counters[i].count.load(std::memory_order_relaxed) > 0)
+    {
+      level = (highest > 0) ?
+              qRound(static_cast<double>(metricValue(_counters[i])) / highest *
+                     (LevelCount - 1)) :
+              0;
+
+      level = qBound(0, level, LevelCount - 1);
+    }
+
+    if (_levels[i] == level)
+      continue;
+
+    _levels[i] = static_cast<qint8>(level);
+
+    changed.push_back(i);
+  }
+
+  if (_shown && !changed.empty())
+    _scene.updateHeatLevels(changed, _coloringConnections);
+}
+
+
+qint64
+NodeHeatmap::
+metricValue(Counters const & counters) const
+{
+  switch (_metric)
+  {
+    case Metric::ExecutionCount:
+      return static_cast<qint64>(counters.count.load(std::memory_order_relaxed));
+
+    case Metric::CumulativeTime:
+      return counters.totalTime.load(std::memory_order_relaxed);
+
+    case Metric::LastLatency:
+      return counters.lastLatency.load(std::memory_order_relaxed);
+  }
+
+  return 0;
+}
+
+
+std::vector<NodeId>
+NodeHeatmap::
+levelledNodes() const
+{
+  std::vector<NodeId> nodeIds;
+
+  for (NodeId i = 0; i < _levels.size(); ++i)
+  {
+    if (_levels[i] >= 0)
+      nodeIds.push_back(i);
+  }
+
+  return nodeIds;
+}
+
+
+void
+NodeHeatmap::
+invalidate()
+{
+  std::fill(_levels.begin(), _levels.end(), -1);
+
+  _changed.store(true, std::memory_order_release);
+}
+
+}
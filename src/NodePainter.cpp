@@ -1,15 +1,22 @@
 #include "NodePainter.hpp"
 
+#include <algorithm>
 #include <cmath>
 
+#include <QtCore/QDataStream>
 #include <QtCore/QMargins>
+#include <QtCore/QtMath>
 
 #include "AbstractGraphModel.hpp"
+#include "BasicGraphicsScene.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionIdUtils.hpp"
 #include "NodeGeometry.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "NodeHeatmap.hpp"
+#include "NodePixmapCache.hpp"
 #include "NodeState.hpp"
+#include "NodeTextCache.hpp"
 #include "StyleCollection.hpp"
 
 
@@ -19,20 +26,46 @@ namespace QtNodes
 void
 NodePainter::
 paint(QPainter * painter,
-      NodeGraphicsObject & ngo)
+      NodeGraphicsObject & ngo,
+      qreal lod)
 {
+  // Resolved once, the palette makes it a lookup without any copy.
+  // Zero thresholds (styles without the keys) keep the full detail.
+  NodeStyle const & nodeStyle = ngo.nodeScene()->nodeStyle(ngo.nodeId());
+
+  NodeHeatmap const * heatmap = ngo.nodeScene()->heatmap();
+
+  QColor const heat = heatmap ? heatmap->color(ngo.nodeId()) : QColor();
+
+  if (lod < nodeStyle.LowDetailScale)
+  {
+    drawPlainNodeRect(painter, ngo, nodeStyle);
+
+    if (heat.isValid())
+      drawHeatOverlay(painter, ngo, nodeStyle, heat);
+
+    return;
+  }
+
   NodeGeometry geometry(ngo);
   geometry.recalculateSizeIfFontChanged(painter->font());
 
-  drawNodeRect(painter, ngo);
+  drawNodeRect(painter, ngo, nodeStyle);
+
+  if (heat.isValid())
+    drawHeatOverlay(painter, ngo, nodeStyle, heat);
 
-  drawConnectionPoints(painter, ngo);
+  drawConnectionPoints(painter, ngo, nodeStyle);
 
-  drawFilledConnectionPoints(painter, ngo);
+  drawFilledConnectionPoints(painter, ngo, nodeStyle);
+
+  // The text is unreadable and the most expensive to draw.
+  if (lod < nodeStyle.MediumDetailScale)
+    return;
 
-  drawNodeCaption(painter, ngo);
+  drawNodeCaption(painter, ngo, nodeStyle);
 
-  drawEntryLabels(painter, ngo);
+  drawEntryLabels(painter, ngo, nodeStyle);
 
   drawResizeRect(painter, ngo);
 }
@@ -40,20 +73,147 @@ paint(QPainter * painter,
 
 void
 NodePainter::
-drawNodeRect(QPainter * painter,
-             NodeGraphicsObject &ngo)
+paintCached(QPainter * painter,
+            NodeGraphicsObject & ngo,
+            qreal lod,
+            NodePixmapCache & cache)
 {
-  AbstractGraphModel const &model = ngo.graphModel();
+  int const zoomBucket =
+    qRound(4.0 * std::log2(std::max<qreal>(lod, 1.0 / 64.0)));
+
+  qreal const zoom = std::pow(2.0, zoomBucket / 4.0);
+
+  qreal const devicePixelRatio =
+    painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+
+  QRectF const rect = ngo.boundingRect();
+
+  QByteArray const key =
+    cacheKey(ngo, painter->font(), zoomBucket, devicePixelRatio);
+
+  QPixmap pixmap;
+
+  if (!cache.find(key, pixmap))
+  {
+    qreal const scale = zoom * devicePixelRatio;
+
+    QSize const size(qCeil(rect.width() * scale),
+                     qCeil(rect.height() * scale));
+
+    if (size.isEmpty())
+      return;
+
+    pixmap = QPixmap(size);
+    pixmap.fill(Qt::transparent);
+
+    {
+      QPainter p(&pixmap);
+      p.setRenderHints(painter->renderHints());
+      p.setFont(painter->font());
+      p.scale(scale, scale);
+      p.translate(-rect.topLeft());
+
+      paint(&p, ngo, zoom);
+    }
+
+    cache.insert(key, pixmap);
+  }
+
+  painter->drawPixmap(rect, pixmap, QRectF(pixmap.rect()));
+}
 
-  NodeId const nodeId = ngo.nodeId();
 
+QByteArray
+NodePainter::
+cacheKey(NodeGraphicsObject & ngo,
+         QFont const & font,
+         int zoomBucket,
+         qreal devicePixelRatio)
+{
+  NodeId const nodeId = ngo.nodeId();
   NodeGeometry geom(ngo);
-  QSize size = geom.size();
 
-  QJsonDocument json =
-    QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
+  NodeHeatmap const * heatmap = ngo.nodeScene()->heatmap();
 
-  NodeStyle nodeStyle(json.object());
+  QColor const heat = heatmap ? heatmap->color(nodeId) : QColor();
+
+  QByteArray key = contentKey(ngo);
+  QDataStream stream(&key, QIODevice::Append);
+
+  stream << geom.size()
+         << ngo.nodeScene()->nodeStatus(nodeId)
+         << (heat.isValid() ? heat.rgba() : 0u)
+         << ngo.isSelected()
+         << ngo.nodeState().hovered()
+         << font.toString()
+         << zoomBucket
+         << devicePixelRatio;
+
+  return key;
+}
+
+
+QByteArray const &
+NodePainter::
+contentKey(NodeGraphicsObject & ngo)
+{
+  QByteArray & key = ngo.contentKey();
+
+  if (!key.isEmpty())
+    return key;
+
+  AbstractGraphModel const &model = ngo.graphModel();
+  NodeId const nodeId = ngo.nodeId();
+
+  // A palette handle or the JSON serialized once by the scene.
+  QByteArray const style = ngo.nodeScene()->nodeStyleKey(nodeId);
+
+  QDataStream stream(&key, QIODevice::WriteOnly);
+
+  stream << model.nodeData(nodeId, NodeRole::Type).toString()
+         << model.nodeData(nodeId, NodeRole::CaptionVisible).toBool()
+         << model.nodeData(nodeId, NodeRole::Caption).toString()
+         << style
+         << model.nodeFlags(nodeId).testFlag(NodeFlag::Resizable);
+
+  for (PortType portType: {PortType::Out, PortType::In})
+  {
+    size_t const n =
+      model.nodeData(nodeId,
+                     (portType == PortType::Out) ?
+                     NodeRole::NumberOfOutPorts :
+                     NodeRole::NumberOfInPorts).toUInt();
+
+    stream << static_cast<quint32>(n);
+
+    for (PortIndex portIndex = 0; portIndex < n; ++portIndex)
+    {
+      auto const dataType =
+        model.portData(nodeId, portType, portIndex,
+                       PortRole::DataType).value<NodeDataType>();
+
+      stream << model.portData(nodeId, portType, portIndex,
+                               PortRole::CaptionVisible).toBool()
+             << model.portData(nodeId, portType, portIndex,
+                               PortRole::Caption).toString()
+             << dataType.id
+             << dataType.name
+             << !model.connections(nodeId, portType, portIndex).empty();
+    }
+  }
+
+  return key;
+}
+
+
+void
+NodePainter::
+drawNodeRect(QPainter * painter,
+             NodeGraphicsObject &ngo,
+             NodeStyle const & nodeStyle)
+{
+  NodeGeometry geom(ngo);
+  QSize size = geom.size();
 
   auto color = ngo.isSelected() ?
                nodeStyle.SelectedBoundaryColor :
@@ -92,19 +252,63 @@ drawNodeRect(QPainter * painter,
 }
 
 
+void
+NodePainter::
+drawPlainNodeRect(QPainter * painter,
+                  NodeGraphicsObject &ngo,
+                  NodeStyle const & nodeStyle)
+{
+  NodeGeometry geom(ngo);
+  QSize size = geom.size();
+
+  painter->setPen(Qt::NoPen);
+  painter->setBrush(ngo.isSelected() ?
+                    nodeStyle.SelectedBoundaryColor :
+                    nodeStyle.GradientColor1);
+
+  float diam = nodeStyle.ConnectionPointDiameter;
+
+  painter->drawRect(QRectF(-diam, -diam,
+                           2.0 * diam + size.width(),
+                           2.0 * diam + size.height()));
+}
+
+
+void
+NodePainter::
+drawHeatOverlay(QPainter * painter,
+                NodeGraphicsObject &ngo,
+                NodeStyle const & nodeStyle,
+                QColor const & heat)
+{
+  NodeGeometry geom(ngo);
+  QSize size = geom.size();
+
+  painter->setPen(Qt::NoPen);
+  painter->setBrush(heat);
+
+  float diam = nodeStyle.ConnectionPointDiameter;
+
+  QRectF boundary(-diam, -diam,
+                  2.0 * diam + size.width(),
+                  2.0 * diam + size.height());
+
+  double const radius = 3.0;
+
+  painter->drawRoundedRect(boundary, radius, radius);
+}
+
+
 void
 NodePainter::
 drawConnectionPoints(QPainter * painter,
-                     NodeGraphicsObject &ngo)
+                     NodeGraphicsObject &ngo,
+                     NodeStyle const & nodeStyle)
 {
   AbstractGraphModel const &model = ngo.graphModel();
   NodeId const nodeId     = ngo.nodeId();
   NodeGeometry geom(ngo);
 
-  QJsonDocument json =
-    QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-  NodeStyle nodeStyle(json.object());
-
   auto const &connectionStyle = StyleCollection::connectionStyle();
 
   float diameter       = nodeStyle.ConnectionPointDiameter;
@@ -195,16 +399,13 @@ drawConnectionPoints(QPainter * painter,
 void
 NodePainter::
 drawFilledConnectionPoints(QPainter * painter,
-                           NodeGraphicsObject &ngo)
+                           NodeGraphicsObject &ngo,
+                           NodeStyle const & nodeStyle)
 {
   AbstractGraphModel const &model = ngo.graphModel();
   NodeId const nodeId     = ngo.nodeId();
   NodeGeometry geom(ngo);
 
-  QJsonDocument json =
-    QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-  NodeStyle nodeStyle(json.object());
-
   auto diameter = nodeStyle.ConnectionPointDiameter;
 
   for (PortType portType: {PortType::Out, PortType::In})
@@ -255,7 +456,8 @@ drawFilledConnectionPoints(QPainter * painter,
 void
 NodePainter::
 drawNodeCaption(QPainter * painter,
-                NodeGraphicsObject &ngo)
+                NodeGraphicsObject &ngo,
+                NodeStyle const & nodeStyle)
 {
   AbstractGraphModel const &model = ngo.graphModel();
   NodeId const nodeId     = ngo.nodeId();
@@ -269,20 +471,16 @@ drawNodeCaption(QPainter * painter,
   QFont f = painter->font();
   f.setBold(true);
 
-  QFontMetrics metrics(f);
-  auto rect  = metrics.boundingRect(name);
+  auto const & text = ngo.textCache().caption(name, f);
   QSize size = geom.size();
 
-  QPointF position((size.width() - rect.width()) / 2.0,
-                   (geom.verticalSpacing() + geom.entryHeight()) / 3.0);
-
-  QJsonDocument json =
-    QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-  NodeStyle nodeStyle(json.object());
+  // drawStaticText() places the top of the text, not its baseline.
+  QPointF position((size.width() - text.width) / 2.0,
+                   (geom.verticalSpacing() + geom.entryHeight()) / 3.0 - text.ascent);
 
   painter->setFont(f);
   painter->setPen(nodeStyle.FontColor);
-  painter->drawText(position, name);
+  painter->drawStaticText(position, text.staticText);
 
   f.setBold(false);
   painter->setFont(f);
@@ -292,18 +490,19 @@ drawNodeCaption(QPainter * painter,
 void
 NodePainter::
 drawEntryLabels(QPainter * painter,
-                NodeGraphicsObject &ngo)
+                NodeGraphicsObject &ngo,
+                NodeStyle const & nodeStyle)
 {
   AbstractGraphModel const &model = ngo.graphModel();
   NodeId const nodeId     = ngo.nodeId();
   NodeGeometry geom(ngo);
 
-  QJsonDocument json =
-    QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-  NodeStyle nodeStyle(json.object());
-
   QSize size = geom.size();
 
+  QFont const font = painter->font();
+
+  NodeTextCache & textCache = ngo.textCache();
+
   for (PortType portType: {PortType::Out, PortType::In})
   {
     size_t const n =
@@ -338,10 +537,9 @@ drawEntryLabels(QPainter * painter,
         s = portData.value<NodeDataType>().name;
       }
 
-      QFontMetrics const &metrics = painter->fontMetrics();
-      auto rect = metrics.boundingRect(s);
+      auto const & text = textCache.label(portType, portIndex, s, font);
 
-      p.setY(p.y() + rect.height() / 4.0);
+      p.setY(p.y() + text.height / 4.0 - text.ascent);
 
       switch (portType)
       {
@@ -350,14 +548,14 @@ drawEntryLabels(QPainter * painter,
           break;
 
         case PortType::Out:
-          p.setX(size.width() - 5.0 - rect.width());
+          p.setX(size.width() - 5.0 - text.width);
           break;
 
         default:
           break;
       }
 
-      painter->drawText(p, s);
+      painter->drawStaticText(p, text.staticText);
     }
   }
 }
@@ -11,6 +11,8 @@ class BasicGraphicsScene;
 class GraphModel;
 class NodeGeometry;
 class NodeGraphicsObject;
+class NodePixmapCache;
+class NodeStyle;
 class NodeState;
 
 /// @ Lightweight class incapsulating paint code.
@@ -22,28 +24,74 @@ public:
 
 public:
 
+  /// `lod` is the zoom level, see `NodeStyle::LowDetailScale`.
   static
   void paint(QPainter * painter,
-             NodeGraphicsObject  & ngo);
+             NodeGraphicsObject  & ngo,
+             qreal lod = 1.0);
 
   static
   void drawNodeRect(QPainter * painter,
-                    NodeGraphicsObject  & ngo);
+                    NodeGraphicsObject  & ngo,
+                    NodeStyle const & nodeStyle);
+
+  /// Blits the node from the shared cache, rasterizing it on a miss.
+  /**
+   * The zoom level is rounded to quarter octaves so that a handful of
+   * images per look covers every zoom.
+   */
+  static
+  void paintCached(QPainter * painter,
+                   NodeGraphicsObject  & ngo,
+                   qreal lod,
+                   NodePixmapCache & cache);
+
+  /// Everything the look of the node depends on.
+  /**
+   * The content part is kept by the node, see `contentKey`, only the
+   * state changing between paints is serialized every time.
+   */
+  static
+  QByteArray cacheKey(NodeGraphicsObject  & ngo,
+                      QFont const & font,
+                      int zoomBucket,
+                      qreal devicePixelRatio);
+
+  /// Type, caption, style and ports of the node, built on first use.
+  static
+  QByteArray const & contentKey(NodeGraphicsObject  & ngo);
+
+  /// Flat rectangle used at the lowest level of detail.
+  static
+  void drawPlainNodeRect(QPainter * painter,
+                         NodeGraphicsObject  & ngo,
+                         NodeStyle const & nodeStyle);
+
+  /// Tints the node body with its NodeHeatmap color.
+  static
+  void drawHeatOverlay(QPainter * painter,
+                       NodeGraphicsObject  & ngo,
+                       NodeStyle const & nodeStyle,
+                       QColor const & heat);
 
   static
   void drawConnectionPoints(QPainter * painter,
-                            NodeGraphicsObject  & ngo);
+                            NodeGraphicsObject  & ngo,
+                            NodeStyle const & nodeStyle);
   static
   void drawFilledConnectionPoints(QPainter * painter,
-                                  NodeGraphicsObject  & ngo);
+                                  NodeGraphicsObject  & ngo,
+                                  NodeStyle const & nodeStyle);
 
   static
   void drawNodeCaption(QPainter * painter,
-                       NodeGraphicsObject  & ngo);
+                       NodeGraphicsObject  & ngo,
+                       NodeStyle const & nodeStyle);
 
   static
   void drawEntryLabels(QPainter * painter,
-                       NodeGraphicsObject  & ngo);
+                       NodeGraphicsObject  & ngo,
+                       NodeStyle const & nodeStyle);
 
   static
   void drawResizeRect(QPainter * painter,
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QtGlobal>
+#include <QtGui/QPixmap>
+
+#include <algorithm>
+#include <climits>
+
+
+namespace QtNodes
+{
+
+/// Scene-wide LRU cache of rasterized nodes.
+/**
+ * Nodes looking the same (see `NodePainter::cacheKey`) share one
+ * pixmap. The cost of an entry is its size in KiB, so the byte budget
+ * fits into QCache's `int` costs; the least recently used pixmaps are
+ * evicted first once the budget is exceeded.
+ */
+class NodePixmapCache
+{
+public:
+  explicit
+  NodePixmapCache(qint64 budget)
+  {
+    setBudget(budget);
+  }
+
+  void
+  setBudget(qint64 bytes)
+  {
+    _budget = bytes;
+
+    _cache.setMaxCost(static_cast<int>(std::min<qint64>(bytes / 1024, INT_MAX)));
+  }
+
+  qint64
+  budget() const { return _budget; }
+
+  /// @returns `true` and marks the entry as recently used on a hit.
+  bool
+  find(QByteArray const & key, QPixmap & pixmap)
+  {
+    QPixmap const * cached = _cache.object(key);
+
+    if (!cached)
+      return false;
+
+    pixmap = *cached;
+
+    return true;
+  }
+
+  void
+  insert(QByteArray const & key, QPixmap const & pixmap)
+  {
+    qint64 const bytes =
+      static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+
+    _cache.insert(key,
+                  new QPixmap(pixmap),
+                  static_cast<int>(std::max<qint64>(bytes / 1024, 1)));
+  }
+
+  void
+  clear() { _cache.clear(); }
+
+private:
+  qint64 _budget;
+
+  QCache<QByteArray, QPixmap> _cache;
+};
+
+}
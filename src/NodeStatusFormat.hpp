@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QtEndian>
+#include <QtCore/QtGlobal>
+
+#include "NodeStatusIngestor.hpp"
+
+
+namespace QtNodes
+{
+
+/// Layout of the status recordings, shared by the recorder and the timeline.
+/**
+ * `<file>` holds a header followed by fixed-size big-endian records
+ * `[qint64 timestamp][quint32 node id][qint32 status]`, so the record
+ * `i` is found at `HeaderSize + i * RecordSize`.
+ *
+ * `<file>.index` holds a header followed by keyframes
+ * `[quint64 record index][quint32 count][count x (node id, status)]`,
+ * the statuses of all the nodes before the indexed record.
+ */
+namespace NodeStatusFormat
+{
+
+constexpr quint32 RecordsMagic = 0x514e5354; // "QNST"
+
+constexpr quint32 IndexMagic = 0x514e534b; // "QNSK"
+
+constexpr quint32 Version = 1;
+
+constexpr qint64 HeaderSize = 8;
+
+constexpr qint64 RecordSize = 16;
+
+
+inline
+QString
+indexFileName(QString const & fileName)
+{
+  return fileName + QStringLiteral(".index");
+}
+
+
+inline
+void
+writeHeader(uchar * data, quint32 magic)
+{
+  qToBigEndian<quint32>(magic, data);
+  qToBigEndian<quint32>(Version, data + 4);
+}
+
+
+inline
+bool
+checkHeader(uchar const * data, quint32 magic)
+{
+  return qFromBigEndian<quint32>(data) == magic &&
+         qFromBigEndian<quint32>(data + 4) == Version;
+}
+
+
+inline
+void
+writeRecord(uchar * data, NodeStatusRecord const & record)
+{
+  qToBigEndian<qint64>(record.timestamp, data);
+  qToBigEndian<quint32>(record.nodeId, data + 8);
+  qToBigEndian<qint32>(record.status, data + 12);
+}
+
+
+inline
+NodeStatusRecord
+readRecord(uchar const * data)
+{
+  return NodeStatusRecord{qFromBigEndian<qint64>(data),
+                          qFromBigEndian<quint32>(data + 8),
+                          qFromBigEndian<qint32>(data + 12)};
+}
+
+}
+
+}
@@ -0,0 +1,155 @@
+#include "NodeStatusIngestor.hpp"
+
+#include "BasicGraphicsScene.hpp"
+#include "NodeStatusQueue.hpp"
+
+#include <QtCore/QDateTime>
+
+#include <algorithm>
+#include <utility>
+
+
+namespace QtNodes
+{
+
+NodeStatusIngestor::
+NodeStatusIngestor(BasicGraphicsScene & scene,
+                   std::size_t capacity,
+                   QObject * parent)
+  : QObject(parent)
+  , _scene(scene)
+  , _queue(std::make_unique<NodeStatusQueue>(capacity))
+  , _lockingNodes(true)
+  , _receivedCount(0)
+  , _appliedCount(0)
+  , _lastLag(0)
+  , _maxLag(0)
+{
+  _frameTimer.setInterval(16);
+
+  connect(&_frameTimer, &QTimer::timeout, this, &NodeStatusIngestor::drain);
+}
+
+
+NodeStatusIngestor::
+~NodeStatusIngestor() = default;
+
+
+bool
+NodeStatusIngestor::
+push(NodeId const nodeId, int status, qint64 timestamp)
+{
+  return _queue->push(NodeStatusRecord{timestamp, nodeId, status});
+}
+
+
+bool
+NodeStatusIngestor::
+push(NodeId const nodeId, int status)
+{
+  return push(nodeId, status, QDateTime::currentMSecsSinceEpoch());
+}
+
+
+void
+NodeStatusIngestor::
+start()
+{
+  _frameTimer.start();
+}
+
+
+void
+NodeStatusIngestor::
+stop()
+{
+  _frameTimer.stop();
+}
+
+
+void
+NodeStatusIngestor::
+setFrameInterval(int msec)
+{
+  _frameTimer.setInterval(msec);
+}
+
+
+quint64
+NodeStatusIngestor::
+droppedCount() const
+{
+  return _queue->droppedCount();
+}
+
+
+void
+NodeStatusIngestor::
+resetCounters()
+{
+  _queue->resetDroppedCount();
+
+  _receivedCount = 0;
+  _appliedCount = 0;
+  _lastLag = 0;
+  _maxLag = 0;
+}
+
+
+void
+NodeStatusIngestor::
+drain()
+{
+  _frameIndex.clear();
+  _frameRecords.clear();
+
+  qint64 oldest = 0;
+
+  // Bounded, so that fast producers cannot keep the GUI thread here.
+  std::size_t const limit = _queue->capacity();
+
+  NodeStatusRecord record;
+
+  for (std::size_t i = 0; i < limit && _queue->pop(record); ++i)
+  {
+    if (i == 0 || record.timestamp < oldest)
+      oldest = record.timestamp;
+
+    ++_receivedCount;
+
+    auto it = _frameIndex.find(record.nodeId);
+
+    if (it == _frameIndex.end())
+    {
+      _frameIndex.emplace(record.nodeId, _frameRecords.size());
+      _frameRecords.push_back(record);
+    }
+    else if (record.timestamp >= _frameRecords[it->second].timestamp)
+    {
+      // Producers may interleave, the timestamps decide.
+      _frameRecords[it->second] = record;
+    }
+  }
+
+  if (_frameRecords.empty())
+    return;
+
+  std::vector<std::pair<NodeId, int>> statuses;
+  statuses.reserve(_frameRecords.size());
+
+  for (auto const & r : _frameRecords)
+  {
+    statuses.emplace_back(r.nodeId, r.status);
+  }
+
+  _scene.updateNodeStatuses(statuses, _lockingNodes);
+
+  _appliedCount += _frameRecords.size();
+
+  _lastLag = std::max<qint64>(QDateTime::currentMSecsSinceEpoch() - oldest, 0);
+  _maxLag = std::max(_maxLag, _lastLag);
+
+  Q_EMIT statusesApplied(_frameRecords);
+}
+
+}
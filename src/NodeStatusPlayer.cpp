@@ -0,0 +1,215 @@
+#include "NodeStatusPlayer.hpp"
+
+#include "BasicGraphicsScene.hpp"
+#include "NodeStatusTimeline.hpp"
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+namespace
+{
+
+/// Records read at once, fast playback may pass many per frame.
+constexpr quint64 ReadChunk = 4096;
+
+}
+
+
+NodeStatusPlayer::
+NodeStatusPlayer(BasicGraphicsScene & scene,
+                 NodeStatusTimeline & timeline,
+                 QObject * parent)
+  : QObject(parent)
+  , _scene(scene)
+  , _timeline(timeline)
+  , _speed(1.0)
+  , _lockingNodes(true)
+  , _position(timeline.startTime())
+  , _carry(0.0)
+  , _nextRecord(0)
+{
+  _frameTimer.setInterval(16);
+
+  connect(&_frameTimer, &QTimer::timeout, this, &NodeStatusPlayer::advance);
+}
+
+
+void
+NodeStatusPlayer::
+setSpeed(double speed)
+{
+  if (!(speed > 0.0))
+  {
+    qWarning() << "NodeStatusPlayer: the speed must be positive, got" << speed;
+    return;
+  }
+
+  _speed = speed;
+}
+
+
+void
+NodeStatusPlayer::
+setFrameInterval(int msec)
+{
+  _frameTimer.setInterval(msec);
+}
+
+
+void
+NodeStatusPlayer::
+play()
+{
+  if (!_timeline.isOpen() || isPlaying())
+    return;
+
+  // Playing again from the start once the end was reached, or when the
+  // timeline was opened after the player was created.
+  if (_nextRecord >= _timeline.recordCount() ||
+      _position < _timeline.startTime() ||
+      _position > _timeline.endTime())
+    seek(_timeline.startTime());
+
+  _carry = 0.0;
+  _clock.start();
+  _frameTimer.start();
+}
+
+
+void
+NodeStatusPlayer::
+pause()
+{
+  _frameTimer.stop();
+}
+
+
+void
+NodeStatusPlayer::
+seek(qint64 timestamp)
+{
+  std::unordered_map<NodeId, int> state;
+
+  if (!_timeline.stateAt(timestamp, state))
+  {
+    qWarning() << "Failed to seek the status timeline:" << _timeline.errorString();
+    return;
+  }
+
+  std::vector<std::pair<NodeId, int>> statuses;
+  statuses.reserve(state.size() + _shownNodes.size());
+
+  for (NodeId const nodeId : _shownNodes)
+  {
+    if (state.count(nodeId) == 0)
+      statuses.emplace_back(nodeId, -1);
+  }
+
+  _shownNodes.clear();
+
+  for (auto const & entry : state)
+  {
+    statuses.emplace_back(entry.first, entry.second);
+    _shownNodes.insert(entry.first);
+  }
+
+  _scene.updateNodeStatuses(statuses, _lockingNodes);
+
+  _nextRecord = _timeline.recordsUntil(timestamp);
+  _position = timestamp;
+  _carry = 0.0;
+
+  if (isPlaying())
+    _clock.restart();
+
+  Q_EMIT positionChanged(_position);
+}
+
+
+void
+NodeStatusPlayer::
+advance()
+{
+  double const elapsed = _clock.restart() * _speed + _carry;
+
+  qint64 const step = static_cast<qint64>(elapsed);
+
+  _carry = elapsed - step;
+  _position += step;
+
+  applyUntil(_timeline.recordsUntil(_position));
+
+  bool const atEnd = _nextRecord >= _timeline.recordCount();
+
+  if (atEnd)
+    _position = std::min(_position, _timeline.endTime());
+
+  Q_EMIT positionChanged(_position);
+
+  if (atEnd)
+  {
+    pause();
+
+    Q_EMIT finished();
+  }
+}
+
+
+void
+NodeStatusPlayer::
+applyUntil(quint64 end)
+{
+  std::unordered_map<NodeId, int> latest;
+
+  std::vector<NodeStatusRecord> records;
+
+  while (_nextRecord < end)
+  {
+    if (!_timeline.readRecords(_nextRecord,
+                               std::min(ReadChunk, end - _nextRecord),
+                               records) ||
+        records.empty())
+    {
+      qWarning() << "Failed to read the status timeline:" << _timeline.errorString();
+
+      // Skipped, the playback would otherwise stall on the same records.
+      _nextRecord = end;
+      break;
+    }
+
+    for (auto const & record : records)
+    {
+      latest[record.nodeId] = record.status;
+    }
+
+    _nextRecord += records.size();
+  }
+
+  if (latest.empty())
+    return;
+
+  std::vector<std::pair<NodeId, int>> statuses;
+  statuses.reserve(latest.size());
+
+  for (auto const & entry : latest)
+  {
+    statuses.emplace_back(entry.first, entry.second);
+
+    if (entry.second < 0)
+      _shownNodes.erase(entry.first);
+    else
+      _shownNodes.insert(entry.first);
+  }
+
+  _scene.updateNodeStatuses(statuses, _lockingNodes);
+}
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "NodeStatusIngestor.hpp"
+
+
+namespace QtNodes
+{
+
+/// Bounded lock-free queue of status records, many producers and one consumer.
+/**
+ * Every cell carries a sequence number telling whether it is free for
+ * the producer of a given position or filled for the consumer (the
+ * scheme of D. Vyukov's bounded queue). Producers claim positions with
+ * a CAS on the enqueue counter and never wait for each other; a full
+ * queue rejects the record instead of blocking the producer.
+ */
+class NodeStatusQueue
+{
+public:
+  /// The capacity is rounded up to a power of two.
+  explicit
+  NodeStatusQueue(std::size_t capacity)
+    : _enqueuePos(0)
+    , _dequeuePos(0)
+    , _dropped(0)
+  {
+    std::size_t size = 2;
+    while (size < capacity)
+      size *= 2;
+
+    _mask = size - 1;
+
+    _cells.reset(new Cell[size]);
+
+    for (std::size_t i = 0; i < size; ++i)
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  std::size_t
+  capacity() const { return _mask + 1; }
+
+  /// Thread-safe. @returns `false` and counts a drop when the queue is full.
+  bool
+  push(NodeStatusRecord const & record)
+  {
+    Cell * cell = nullptr;
+
+    std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+      cell = &_cells[pos & _mask];
+
+      std::size_t const sequence = cell->sequence.load(std::memory_order_acquire);
+
+      std::ptrdiff_t const diff =
+        static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+      if (diff == 0)
+      {
+        if (_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        pos = _enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->record = record;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /// Consumer thread only. @returns `false` when the queue is empty.
+  bool
+  pop(NodeStatusRecord & record)
+  {
+    Cell & cell = _cells[_dequeuePos & _mask];
+
+    std::size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+
+    if (sequence != _dequeuePos + 1)
+      return false;
+
+    record = cell.record;
+
+    // Free for the producer of the position one lap ahead.
+    cell.sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+
+    ++_dequeuePos;
+
+    return true;
+  }
+
+  /// Thread-safe.
+  quint64
+  droppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+
+  void
+  resetDroppedCount() { _dropped.store(0, std::memory_order_relaxed); }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+
+    NodeStatusRecord record;
+  };
+
+  std::unique_ptr<Cell[]> _cells;
+
+  std::size_t _mask;
+
+  // Producers and the consumer write different counters, they do not
+  // share a cache line.
+  alignas(64) std::atomic<std::size_t> _enqueuePos;
+
+  alignas(64) std::size_t _dequeuePos;
+
+  alignas(64) std::atomic<quint64> _dropped;
+};
+
+}
@@ -0,0 +1,186 @@
+#include "NodeStatusRecorder.hpp"
+
+#include "NodeStatusFormat.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDebug>
+
+#include <algorithm>
+
+
+namespace QtNodes
+{
+
+NodeStatusRecorder::
+NodeStatusRecorder(QObject * parent)
+  : QObject(parent)
+  , _keyframeInterval(4096)
+  , _recordCount(0)
+  , _lastTimestamp(0)
+{}
+
+
+NodeStatusRecorder::
+~NodeStatusRecorder()
+{
+  close();
+}
+
+
+bool
+NodeStatusRecorder::
+open(QString const & fileName)
+{
+  close();
+
+  _records.setFileName(fileName);
+  _index.setFileName(NodeStatusFormat::indexFileName(fileName));
+
+  if (!_records.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      !_index.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qWarning() << "Failed to open status recording" << fileName << ":"
+               << _records.errorString() << _index.errorString();
+    close();
+    return false;
+  }
+
+  uchar header[NodeStatusFormat::HeaderSize];
+
+  NodeStatusFormat::writeHeader(header, NodeStatusFormat::RecordsMagic);
+
+  bool ok = _records.write(reinterpret_cast<char const *>(header), sizeof(header)) ==
+            static_cast<qint64>(sizeof(header));
+
+  NodeStatusFormat::writeHeader(header, NodeStatusFormat::IndexMagic);
+
+  ok = ok &&
+       _index.write(reinterpret_cast<char const *>(header), sizeof(header)) ==
+       static_cast<qint64>(sizeof(header));
+
+  if (!ok)
+  {
+    qWarning() << "Failed to write status recording" << fileName;
+    close();
+    return false;
+  }
+
+  _recordCount = 0;
+  _lastTimestamp = 0;
+  _state.clear();
+
+  return true;
+}
+
+
+void
+NodeStatusRecorder::
+close()
+{
+  if (_records.isOpen())
+    _records.close();
+
+  if (_index.isOpen())
+    _index.close();
+}
+
+
+void
+NodeStatusRecorder::
+setKeyframeInterval(int records)
+{
+  _keyframeInterval = std::max(records, 1);
+}
+
+
+void
+NodeStatusRecorder::
+record(std::vector<NodeStatusRecord> const & records)
+{
+  for (auto const & r : records)
+  {
+    append(r);
+  }
+}
+
+
+void
+NodeStatusRecorder::
+append(NodeStatusRecord const & record)
+{
+  if (!isOpen())
+    return;
+
+  if (_recordCount % static_cast<quint64>(_keyframeInterval) == 0 &&
+      !writeKeyframe())
+  {
+    qWarning() << "Failed to write status keyframe:" << _index.errorString();
+    close();
+    return;
+  }
+
+  NodeStatusRecord stored = record;
+
+  if (_recordCount > 0)
+    stored.timestamp = std::max(stored.timestamp, _lastTimestamp);
+
+  uchar data[NodeStatusFormat::RecordSize];
+
+  NodeStatusFormat::writeRecord(data, stored);
+
+  if (_records.write(reinterpret_cast<char const *>(data), sizeof(data)) !=
+      static_cast<qint64>(sizeof(data)))
+  {
+    qWarning() << "Failed to write status record:" << _records.errorString();
+    close();
+    return;
+  }
+
+  _lastTimestamp = stored.timestamp;
+
+  if (stored.status < 0)
+    _state.erase(stored.nodeId);
+  else
+    _state[stored.nodeId] = stored.status;
+
+  ++_recordCount;
+}
+
+
+void
+NodeStatusRecorder::
+flush()
+{
+  if (!isOpen())
+    return;
+
+  _records.flush();
+  _index.flush();
+}
+
+
+bool
+NodeStatusRecorder::
+writeKeyframe()
+{
+  QByteArray keyframe(12 + 8 * static_cast<int>(_state.size()), Qt::Uninitialized);
+
+  uchar * data = reinterpret_cast<uchar *>(keyframe.data());
+
+  qToBigEndian<quint64>(_recordCount, data);
+  qToBigEndian<quint32>(static_cast<quint32>(_state.size()), data + 8);
+
+  data += 12;
+
+  for (auto const & entry : _state)
+  {
+    qToBigEndian<quint32>(entry.first, data);
+    qToBigEndian<qint32>(entry.second, data + 4);
+
+    data += 8;
+  }
+
+  return _index.write(keyframe) == keyframe.size();
+}
+
+}
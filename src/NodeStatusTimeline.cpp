@@ -0,0 +1,271 @@
+#include "NodeStatusTimeline.hpp"
+
+#include "NodeStatusFormat.hpp"
+
+#include <QtCore/QByteArray>
+
+#include <algorithm>
+
+
+namespace QtNodes
+{
+
+NodeStatusTimeline::
+NodeStatusTimeline()
+  : _recordCount(0)
+  , _startTime(0)
+  , _endTime(0)
+{}
+
+
+bool
+NodeStatusTimeline::
+open(QString const & fileName)
+{
+  close();
+
+  _records.setFileName(fileName);
+
+  bool const ok = readHeader() &&
+                  readIndex(NodeStatusFormat::indexFileName(fileName));
+
+  if (!ok)
+    close();
+
+  return ok;
+}
+
+
+void
+NodeStatusTimeline::
+close()
+{
+  _records.close();
+
+  _recordCount = 0;
+  _startTime = 0;
+  _endTime = 0;
+
+  _keyframes.clear();
+}
+
+
+quint64
+NodeStatusTimeline::
+recordsUntil(qint64 timestamp)
+{
+  // Upper bound over the records, sorted by the recorder.
+  quint64 first = 0;
+  quint64 count = _recordCount;
+
+  while (count > 0)
+  {
+    quint64 const step = count / 2;
+    quint64 const middle = first + step;
+
+    qint64 middleTimestamp = 0;
+
+    if (!readTimestamp(middle, middleTimestamp))
+      return first;
+
+    if (middleTimestamp <= timestamp)
+    {
+      first = middle + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+
+  return first;
+}
+
+
+bool
+NodeStatusTimeline::
+readRecords(quint64 first,
+            quint64 count,
+            std::vector<NodeStatusRecord> & records)
+{
+  records.clear();
+
+  if (first >= _recordCount)
+    return true;
+
+  count = std::min(count, _recordCount - first);
+
+  if (!_records.seek(NodeStatusFormat::HeaderSize +
+                     static_cast<qint64>(first) * NodeStatusFormat::RecordSize))
+    return fail(_records.errorString());
+
+  QByteArray const data =
+    _records.read(static_cast<qint64>(count) * NodeStatusFormat::RecordSize);
+
+  if (data.size() != static_cast<qint64>(count) * NodeStatusFormat::RecordSize)
+    return fail(_records.errorString());
+
+  records.reserve(count);
+
+  auto const * bytes = reinterpret_cast<uchar const *>(data.constData());
+
+  for (quint64 i = 0; i < count; ++i)
+  {
+    records.push_back(NodeStatusFormat::readRecord(bytes));
+    bytes += NodeStatusFormat::RecordSize;
+  }
+
+  return true;
+}
+
+
+bool
+NodeStatusTimeline::
+stateAt(qint64 timestamp, std::unordered_map<NodeId, int> & state)
+{
+  state.clear();
+
+  quint64 const end = recordsUntil(timestamp);
+
+  auto it = std::upper_bound(_keyframes.begin(), _keyframes.end(), end,
+                             [](quint64 index, Keyframe const & keyframe)
+                             {
+                               return index < keyframe.recordIndex;
+                             });
+
+  quint64 begin = 0;
+
+  if (it != _keyframes.begin())
+  {
+    --it;
+
+    begin = it->recordIndex;
+
+    for (auto const & entry : it->statuses)
+    {
+      state.insert(entry);
+    }
+  }
+
+  std::vector<NodeStatusRecord> records;
+
+  if (!readRecords(begin, end - begin, records))
+    return false;
+
+  for (auto const & record : records)
+  {
+    if (record.status < 0)
+      state.erase(record.nodeId);
+    else
+      state[record.nodeId] = record.status;
+  }
+
+  return true;
+}
+
+
+bool
+NodeStatusTimeline::
+readHeader()
+{
+  if (!_records.open(QIODevice::ReadOnly))
+    return fail(_records.errorString());
+
+  QByteArray const header = _records.read(NodeStatusFormat::HeaderSize);
+
+  if (header.size() != NodeStatusFormat::HeaderSize ||
+      !NodeStatusFormat::checkHeader(reinterpret_cast<uchar const *>(header.constData()),
+                                     NodeStatusFormat::RecordsMagic))
+    return fail(QStringLiteral("Not a status recording"));
+
+  _recordCount = static_cast<quint64>(
+    (_records.size() - NodeStatusFormat::HeaderSize) / NodeStatusFormat::RecordSize);
+
+  if (_recordCount > 0 &&
+      (!readTimestamp(0, _startTime) || !readTimestamp(_recordCount - 1, _endTime)))
+    return fail(_records.errorString());
+
+  return true;
+}
+
+
+bool
+NodeStatusTimeline::
+readIndex(QString const & fileName)
+{
+  QFile index(fileName);
+
+  if (!index.open(QIODevice::ReadOnly))
+    return fail(index.errorString());
+
+  QByteArray const data = index.readAll();
+
+  auto const * bytes = reinterpret_cast<uchar const *>(data.constData());
+  auto const * end = bytes + data.size();
+
+  if (data.size() < NodeStatusFormat::HeaderSize ||
+      !NodeStatusFormat::checkHeader(bytes, NodeStatusFormat::IndexMagic))
+    return fail(QStringLiteral("Not a status recording index"));
+
+  bytes += NodeStatusFormat::HeaderSize;
+
+  // A keyframe cut short by a crash ends the index.
+  while (end - bytes >= 12)
+  {
+    Keyframe keyframe;
+
+    keyframe.recordIndex = qFromBigEndian<quint64>(bytes);
+
+    quint32 const count = qFromBigEndian<quint32>(bytes + 8);
+
+    if (static_cast<quint64>(end - bytes - 12) < 8ull * count ||
+        keyframe.recordIndex > _recordCount)
+      break;
+
+    bytes += 12;
+
+    keyframe.statuses.reserve(count);
+
+    for (quint32 i = 0; i < count; ++i)
+    {
+      keyframe.statuses.emplace_back(qFromBigEndian<quint32>(bytes),
+                                     qFromBigEndian<qint32>(bytes + 4));
+      bytes += 8;
+    }
+
+    _keyframes.push_back(std::move(keyframe));
+  }
+
+  return true;
+}
+
+
+bool
+NodeStatusTimeline::
+readTimestamp(quint64 index, qint64 & timestamp)
+{
+  uchar data[8];
+
+  if (!_records.seek(NodeStatusFormat::HeaderSize +
+                     static_cast<qint64>(index) * NodeStatusFormat::RecordSize) ||
+      _records.read(reinterpret_cast<char *>(data), sizeof(data)) !=
+      static_cast<qint64>(sizeof(data)))
+    return false;
+
+  timestamp = qFromBigEndian<qint64>(data);
+
+  return true;
+}
+
+
+bool
+NodeStatusTimeline::
+fail(QString const & message)
+{
+  _errorString = message;
+
+  return false;
+}
+
+}
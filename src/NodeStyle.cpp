@@ -118,6 +118,9 @@ loadJson(QJsonObject const & json)
   NODE_STYLE_READ_FLOAT(obj, ConnectionPointDiameter);
 
   NODE_STYLE_READ_FLOAT(obj, Opacity);
+
+  NODE_STYLE_READ_FLOAT(obj, LowDetailScale);
+  NODE_STYLE_READ_FLOAT(obj, MediumDetailScale);
 }
 
 
@@ -147,6 +150,9 @@ toJson() const
 
   NODE_STYLE_WRITE_FLOAT(obj, Opacity);
 
+  NODE_STYLE_WRITE_FLOAT(obj, LowDetailScale);
+  NODE_STYLE_WRITE_FLOAT(obj, MediumDetailScale);
+
   QJsonObject root;
   root["NodeStyle"] = obj;
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtGui/QFont>
+#include <QtGui/QFontMetricsF>
+#include <QtGui/QStaticText>
+#include <QtGui/QTransform>
+
+#include <vector>
+
+#include "Definitions.hpp"
+
+
+namespace QtNodes
+{
+
+/// Caption and port labels of one node, shaped once.
+/**
+ * Every text is laid out into a QStaticText on first use and reused as
+ * long as its string and font stay the same, so painting a node does
+ * no text shaping. A changed caption, port caption, data type name or
+ * font only re-lays out the affected text.
+ */
+class NodeTextCache
+{
+public:
+  struct Text
+  {
+    QString string;
+
+    QFont font;
+
+    QStaticText staticText;
+
+    /// Advance width of the laid out text.
+    qreal width = 0.0;
+
+    /// Line height of the font.
+    qreal height = 0.0;
+
+    /// Distance from the top of the text to its baseline.
+    qreal ascent = 0.0;
+  };
+
+public:
+  Text const &
+  caption(QString const & string, QFont const & font)
+  {
+    return prepare(_caption, string, font);
+  }
+
+  Text const &
+  label(PortType portType,
+        PortIndex portIndex,
+        QString const & string,
+        QFont const & font)
+  {
+    auto & labels = (portType == PortType::In) ? _inLabels : _outLabels;
+
+    if (labels.size() <= portIndex)
+      labels.resize(portIndex + 1);
+
+    return prepare(labels[portIndex], string, font);
+  }
+
+private:
+  static
+  Text const &
+  prepare(Text & text, QString const & string, QFont const & font)
+  {
+    if (text.string == string && text.font == font)
+      return text;
+
+    text.string = string;
+    text.font = font;
+
+    text.staticText.setTextFormat(Qt::PlainText);
+    text.staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+    text.staticText.setText(string);
+    text.staticText.prepare(QTransform(), font);
+
+    QFontMetricsF const metrics(font);
+
+    text.width = text.staticText.size().width();
+    text.height = metrics.height();
+    text.ascent = metrics.ascent();
+
+    return text;
+  }
+
+private:
+  Text _caption;
+
+  std::vector<Text> _inLabels;
+
+  std::vector<Text> _outLabels;
+};
+
+}
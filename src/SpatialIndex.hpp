@@ -0,0 +1,290 @@
+#pragma once
+
+#include <QtCore/QPointF>
+#include <QtCore/QRectF>
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+
+namespace QtNodes
+{
+
+/// Uniform hash grid over the scene bounds of graph items.
+/**
+ * Every item is registered in all the grid cells its rectangle
+ * overlaps, so moving an item touches only a handful of cells and
+ * costs the same wherever it goes. This suits the node editor better
+ * than a tree, since the items constantly move and have similar sizes.
+ *
+ * Items spanning more than `MaxCellsPerItem` cells (typically long
+ * connections) are kept in a separate list which every query scans.
+ */
+template <typename Key>
+class SpatialIndex
+{
+public:
+  explicit
+  SpatialIndex(qreal cellSize = 256.0)
+    : _cellSize(cellSize)
+  {}
+
+  /// Inserts the item or updates its rectangle.
+  void
+  insert(Key const & key, QRectF const & rect)
+  {
+    remove(key);
+
+    Item item{rect, cellRange(rect), false};
+
+    item.large = (static_cast<qint64>(item.range.x1 - item.range.x0 + 1) *
+                  static_cast<qint64>(item.range.y1 - item.range.y0 + 1)) > MaxCellsPerItem;
+
+    if (item.large)
+    {
+      _large.push_back(key);
+    }
+    else
+    {
+      forEachCell(item.range,
+                  [&](quint64 cell)
+                  {
+                    _cells[cell].push_back(key);
+                  });
+    }
+
+    _items.emplace(key, item);
+  }
+
+  void
+  remove(Key const & key)
+  {
+    auto it = _items.find(key);
+    if (it == _items.end())
+      return;
+
+    if (it->second.large)
+    {
+      eraseFrom(_large, key);
+    }
+    else
+    {
+      forEachCell(it->second.range,
+                  [&](quint64 cell)
+                  {
+                    auto cellIt = _cells.find(cell);
+
+                    eraseFrom(cellIt->second, key);
+
+                    if (cellIt->second.empty())
+                      _cells.erase(cellIt);
+                  });
+    }
+
+    _items.erase(it);
+  }
+
+  bool
+  contains(Key const & key) const { return _items.count(key) > 0; }
+
+  std::size_t
+  size() const { return _items.size(); }
+
+  /// @returns the indexed rectangle or a null one for unknown keys.
+  QRectF
+  rect(Key const & key) const
+  {
+    auto it = _items.find(key);
+
+    return (it != _items.end()) ? it->second.rect : QRectF();
+  }
+
+  void
+  clear()
+  {
+    _cells.clear();
+    _items.clear();
+    _large.clear();
+  }
+
+  /// Calls `visit(key, rect)` once for every item intersecting `rect`.
+  /**
+   * A query covering more cells than are occupied, e.g. a zoomed out
+   * view, walks the occupied cells instead of the covered ones.
+   */
+  template <typename Visitor>
+  void
+  query(QRectF const & rect, Visitor && visit) const
+  {
+    CellRange const range = cellRange(rect);
+
+    auto visitCell =
+      [&](qint32 x, qint32 y, std::vector<Key> const & keys)
+      {
+        for (Key const & key : keys)
+        {
+          Item const & item = _items.at(key);
+
+          // An item spanning several cells is reported from the first
+          // cell shared by the item and the query only.
+          if (x != std::max(item.range.x0, range.x0) ||
+              y != std::max(item.range.y0, range.y0))
+            continue;
+
+          if (item.rect.intersects(rect))
+            visit(key, item.rect);
+        }
+      };
+
+    qint64 const cellCount =
+      static_cast<qint64>(range.x1 - range.x0 + 1) *
+      static_cast<qint64>(range.y1 - range.y0 + 1);
+
+    if (cellCount > static_cast<qint64>(_cells.size()))
+    {
+      for (auto const & cell : _cells)
+      {
+        qint32 const x = static_cast<qint32>(static_cast<quint32>(cell.first >> 32));
+        qint32 const y = static_cast<qint32>(static_cast<quint32>(cell.first));
+
+        if (x >= range.x0 && x <= range.x1 && y >= range.y0 && y <= range.y1)
+          visitCell(x, y, cell.second);
+      }
+    }
+    else
+    {
+      for (qint32 y = range.y0; y <= range.y1; ++y)
+      {
+        for (qint32 x = range.x0; x <= range.x1; ++x)
+        {
+          auto cellIt = _cells.find(cellKey(x, y));
+
+          if (cellIt != _cells.end())
+            visitCell(x, y, cellIt->second);
+        }
+      }
+    }
+
+    for (Key const & key : _large)
+    {
+      Item const & item = _items.at(key);
+
+      if (item.rect.intersects(rect))
+        visit(key, item.rect);
+    }
+  }
+
+  /// Calls `visit(key, rect)` for every item whose rectangle contains `point`.
+  template <typename Visitor>
+  void
+  query(QPointF const & point, Visitor && visit) const
+  {
+    auto cellIt = _cells.find(cellKey(cellCoordinate(point.x()),
+                                      cellCoordinate(point.y())));
+
+    if (cellIt != _cells.end())
+    {
+      for (Key const & key : cellIt->second)
+      {
+        Item const & item = _items.at(key);
+
+        if (item.rect.contains(point))
+          visit(key, item.rect);
+      }
+    }
+
+    for (Key const & key : _large)
+    {
+      Item const & item = _items.at(key);
+
+      if (item.rect.contains(point))
+        visit(key, item.rect);
+    }
+  }
+
+private:
+  static constexpr qint64 MaxCellsPerItem = 64;
+
+  struct CellRange
+  {
+    qint32 x0;
+    qint32 y0;
+    qint32 x1;
+    qint32 y1;
+  };
+
+  struct Item
+  {
+    QRectF rect;
+    CellRange range;
+    bool large;
+  };
+
+  qint32
+  cellCoordinate(qreal v) const
+  {
+    qreal const c = std::floor(v / _cellSize);
+
+    return static_cast<qint32>(std::clamp<qreal>(c, -1e9, 1e9));
+  }
+
+  CellRange
+  cellRange(QRectF const & rect) const
+  {
+    QRectF const r = rect.normalized();
+
+    return CellRange{cellCoordinate(r.left()),
+                     cellCoordinate(r.top()),
+                     cellCoordinate(r.right()),
+                     cellCoordinate(r.bottom())};
+  }
+
+  static
+  quint64
+  cellKey(qint32 x, qint32 y)
+  {
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) |
+           static_cast<quint32>(y);
+  }
+
+  template <typename Function>
+  static
+  void
+  forEachCell(CellRange const & range, Function && function)
+  {
+    for (qint32 y = range.y0; y <= range.y1; ++y)
+    {
+      for (qint32 x = range.x0; x <= range.x1; ++x)
+      {
+        function(cellKey(x, y));
+      }
+    }
+  }
+
+  static
+  void
+  eraseFrom(std::vector<Key> & keys, Key const & key)
+  {
+    auto it = std::find(keys.begin(), keys.end(), key);
+
+    if (it != keys.end())
+    {
+      *it = keys.back();
+      keys.pop_back();
+    }
+  }
+
+private:
+  qreal _cellSize;
+
+  std::unordered_map<quint64, std::vector<Key>> _cells;
+
+  std::unordered_map<Key, Item> _items;
+
+  std::vector<Key> _large;
+};
+
+}
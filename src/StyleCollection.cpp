@@ -1,5 +1,9 @@
 #include "StyleCollection.hpp"
 
+#include <QtCore/QJsonDocument>
+
+#include <utility>
+
 using QtNodes::StyleCollection;
 using QtNodes::NodeStyle;
 using QtNodes::ConnectionStyle;
@@ -13,6 +17,19 @@ nodeStyle()
 }
 
 
+NodeStyle const &
+StyleCollection::
+nodeStyle(int handle)
+{
+  auto const & styles = instance()._nodeStyles;
+
+  if (handle <= 0 || handle > static_cast<int>(styles.size()))
+    return instance()._nodeStyle;
+
+  return styles[handle - 1];
+}
+
+
 ConnectionStyle const &
 StyleCollection::
 connectionStyle()
@@ -53,6 +70,29 @@ setGraphicsViewStyle(GraphicsViewStyle flowViewStyle)
 }
 
 
+int
+StyleCollection::
+registerNodeStyle(NodeStyle style)
+{
+  auto & styles = instance()._nodeStyles;
+  auto & handles = instance()._nodeStyleHandles;
+
+  QByteArray const json = QJsonDocument(style.toJson()).toJson(QJsonDocument::Compact);
+
+  auto it = handles.constFind(json);
+  if (it != handles.constEnd())
+    return it.value();
+
+  styles.push_back(std::move(style));
+
+  int const handle = static_cast<int>(styles.size());
+
+  handles.insert(json, handle);
+
+  return handle;
+}
+
+
 StyleCollection &
 StyleCollection::
 instance()
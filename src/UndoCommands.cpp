@@ -5,10 +5,12 @@
 #include "ConnectionGraphicsObject.hpp"
 #include "NodeGraphicsObject.hpp"
 
+#include <QtCore/QCborValue>
 #include <QtCore/QJsonArray>
 #include <QtWidgets/QGraphicsObject>
 
 #include <typeinfo>
+#include <utility>
 
 
 namespace QtNodes
@@ -20,60 +22,41 @@ DeleteCommand(BasicGraphicsScene* scene)
 {
   auto & graphModel = _scene->graphModel();
 
-  QJsonArray connJsonArray;
-  // Delete the selected connections first, ensuring that they won't be
-  // automatically deleted when selected nodes are deleted (deleting a
-  // node deletes some connections as well)
-  for (QGraphicsItem * item : _scene->selectedItems())
-  {
-    if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject*>(item))
-    {
-      auto const& cid = c->connectionId();
+  // A connection may be selected and attached to a selected node at
+  // the same time, it is stored once.
+  std::unordered_set<ConnectionId> connectionIds;
 
-      connJsonArray.append(graphModel.saveConnection(cid));
-    }
+  for (ConnectionId const & connectionId : _scene->selectedConnections())
+  {
+    connectionIds.insert(connectionId);
   }
 
-  QJsonArray nodesJsonArray;
-  // Delete the nodes; this will delete many of the connections.
-  // Selected connections were already deleted prior to this loop,
-  for (QGraphicsItem * item : _scene->selectedItems())
+  for (NodeId const nodeId : _scene->selectedNodes())
   {
-    if (auto n = qgraphicsitem_cast<NodeGraphicsObject*>(item))
-    {
-      // saving connections attached to the selected nodes
-      for (auto const & cid : graphModel.allConnectionIds(n->nodeId()))
-      {
-        connJsonArray.append(graphModel.saveConnection(cid));
-      }
-
-      nodesJsonArray.append(graphModel.saveNode(n->nodeId()));
-    }
+    auto const attached = graphModel.allConnectionIds(nodeId);
+    connectionIds.insert(attached.begin(), attached.end());
+
+    _nodeIds.push_back(nodeId);
+    _nodeRecords.push_back(
+      QCborValue::fromJsonValue(graphModel.saveNode(nodeId)).toCbor());
   }
 
-  _sceneJson["nodes"] = nodesJsonArray;
-  _sceneJson["connections"] = connJsonArray;
+  _connectionIds.assign(connectionIds.begin(), connectionIds.end());
 }
 
 void
 DeleteCommand::
 undo()
 {
-  auto & graphModel = _scene->graphModel();
+  std::vector<QJsonObject> nodesJson;
+  nodesJson.reserve(_nodeRecords.size());
 
-  QJsonArray nodesJsonArray = _sceneJson["nodes"].toArray();
-
-  for (QJsonValueRef node : nodesJsonArray)
+  for (QByteArray const & record : _nodeRecords)
   {
-    graphModel.loadNode(node.toObject());
+    nodesJson.push_back(QCborValue::fromCbor(record).toJsonValue().toObject());
   }
 
-  QJsonArray connectionJsonArray = _sceneJson["connections"].toArray();
-
-  for (QJsonValueRef connection : connectionJsonArray)
-  {
-    graphModel.loadConnection(connection.toObject());
-  }
+  _scene->graphModel().loadSubgraph(nodesJson, _connectionIds);
 }
 
 
@@ -81,31 +64,37 @@ void
 DeleteCommand::
 redo()
 {
-  auto & graphModel = _scene->graphModel();
+  _scene->graphModel().deleteSubgraph(_nodeIds, _connectionIds);
 
-  QJsonArray nodesJsonArray = _sceneJson["nodes"].toArray();
+  Q_EMIT _scene->selectionRemoved();
+}
 
-  for (QJsonValueRef node : nodesJsonArray)
-  {
-    QJsonObject nodeJson = node.toObject();
-    graphModel.deleteNode(static_cast<NodeId>(nodeJson["id"].toInt()));
-  }
 
-  QJsonArray connectionJsonArray = _sceneJson["connections"].toArray();
+std::size_t
+DeleteCommand::
+memoryUsage() const
+{
+  std::size_t result = sizeof(*this) +
+                       _nodeIds.capacity() * sizeof(NodeId) +
+                       _nodeRecords.capacity() * sizeof(QByteArray) +
+                       _connectionIds.capacity() * sizeof(ConnectionId);
 
-  for (QJsonValueRef connection : connectionJsonArray)
+  for (QByteArray const & record : _nodeRecords)
   {
-    QJsonObject connJson = connection.toObject();
+    result += static_cast<std::size_t>(record.capacity());
+  }
 
-    ConnectionId connId{static_cast<NodeId>(connJson["outNodeId"].toInt()),
-                        static_cast<PortIndex>(connJson["outPortIndex"].toInt()),
-                        static_cast<NodeId>(connJson["intNodeId"].toInt()),
-                        static_cast<PortIndex>(connJson["inPortIndex"].toInt())};
+  return result;
+}
 
-    graphModel.deleteConnection(connId);
-  }
 
-  Q_EMIT _scene->selectionRemoved();
+void
+DeleteCommand::
+releasePayload()
+{
+  std::vector<NodeId>().swap(_nodeIds);
+  std::vector<QByteArray>().swap(_nodeRecords);
+  std::vector<ConnectionId>().swap(_connectionIds);
 }
 
 
@@ -138,6 +127,22 @@ redo()
 }
 
 
+std::size_t
+DisconnectCommand::
+memoryUsage() const
+{
+  return sizeof(*this);
+}
+
+
+void
+DisconnectCommand::
+releasePayload()
+{
+  // The connection id is all there is.
+}
+
+
 //------
 
 
@@ -168,65 +173,92 @@ redo()
 }
 
 
+std::size_t
+ConnectCommand::
+memoryUsage() const
+{
+  return sizeof(*this);
+}
+
+
+void
+ConnectCommand::
+releasePayload()
+{
+  // The connection id is all there is.
+}
+
+
 //------
 
 
-MoveNodeCommand::
-MoveNodeCommand(BasicGraphicsScene* scene,
-                NodeId const nodeId,
-                QPointF const &diff)
+MoveNodesCommand::
+MoveNodesCommand(BasicGraphicsScene* scene,
+                 std::unordered_set<NodeId> nodeIds,
+                 QPointF const &diff,
+                 int const gesture)
   : _scene(scene)
-  , _nodeId(nodeId)
+  , _nodeIds(std::move(nodeIds))
   , _diff(diff)
+  , _gesture(gesture)
 {
 }
 
+
 void
-MoveNodeCommand::
+MoveNodesCommand::
 undo()
 {
-  auto oldPos = 
-    _scene->graphModel().nodeData(_nodeId,
-                                  NodeRole::Position).value<QPointF>();
-
-  oldPos -= _diff;
-
-  _scene->graphModel().setNodeData(_nodeId, NodeRole::Position, oldPos);
+  _scene->translateNodes(_nodeIds, -_diff);
 }
 
 
 void
-MoveNodeCommand::
+MoveNodesCommand::
 redo()
 {
-  auto oldPos = 
-    _scene->graphModel().nodeData(_nodeId,
-                                  NodeRole::Position).value<QPointF>();
-
-  oldPos += _diff;
-
-  _scene->graphModel().setNodeData(_nodeId, NodeRole::Position, oldPos);
+  _scene->translateNodes(_nodeIds, _diff);
 }
 
 
 int
-MoveNodeCommand::
+MoveNodesCommand::
 id() const
 {
-  return static_cast<int>(typeid(MoveNodeCommand).hash_code());
+  return static_cast<int>(typeid(MoveNodesCommand).hash_code());
 }
 
 
 bool
-MoveNodeCommand::
-mergeWith(QUndoCommand const *c) 
+MoveNodesCommand::
+mergeWith(QUndoCommand const *c)
 {
-  auto mc = static_cast<MoveNodeCommand const*>(c);
+  auto mc = static_cast<MoveNodesCommand const*>(c);
+
+  if (mc->_gesture != _gesture || mc->_nodeIds != _nodeIds)
+    return false;
 
   _diff += mc->_diff;
 
   return true;
 }
 
+
+std::size_t
+MoveNodesCommand::
+memoryUsage() const
+{
+  // Rough size of a hash set node.
+  return sizeof(*this) + _nodeIds.size() * (sizeof(NodeId) + 2 * sizeof(void*));
+}
+
+
+void
+MoveNodesCommand::
+releasePayload()
+{
+  std::unordered_set<NodeId>().swap(_nodeIds);
+}
+
 //
 }
@@ -3,16 +3,48 @@
 #include "Definitions.hpp"
 
 #include <QtGui/QUndoCommand>
+#include <QtCore/QByteArray>
 #include <QtCore/QPointF>
 #include <QtCore/QJsonObject>
 
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
 namespace QtNodes
 {
 
 class BasicGraphicsScene;
 
 
-class DeleteCommand : public QUndoCommand
+/// Commands with a variable-size payload counted against the undo
+/// memory budget of the scene.
+class UndoPayload
+{
+public:
+  virtual
+  ~UndoPayload() = default;
+
+  /// Approximate number of bytes held by the command.
+  virtual
+  std::size_t
+  memoryUsage() const = 0;
+
+  /// Frees the payload of a command evicted from the history.
+  virtual
+  void
+  releasePayload() = 0;
+};
+
+
+/// Deletes the selected nodes and connections.
+/**
+ * Nodes are kept as CBOR-encoded `saveNode` records, connections as a
+ * deduplicated list of ids.
+ */
+class DeleteCommand
+  : public QUndoCommand
+  , public UndoPayload
 {
 public:
   DeleteCommand(BasicGraphicsScene* scene);
@@ -20,14 +52,24 @@ public:
   void undo() override;
   void redo() override;
 
+  std::size_t memoryUsage() const override;
+
+  void releasePayload() override;
+
 private:
   BasicGraphicsScene* _scene;
 
-  QJsonObject _sceneJson;
+  std::vector<NodeId> _nodeIds;
+
+  std::vector<QByteArray> _nodeRecords;
+
+  std::vector<ConnectionId> _connectionIds;
 };
 
 
-class DisconnectCommand : public QUndoCommand
+class DisconnectCommand
+  : public QUndoCommand
+  , public UndoPayload
 {
 public:
   DisconnectCommand(BasicGraphicsScene* scene,
@@ -36,6 +78,10 @@ public:
   void undo() override;
   void redo() override;
 
+  std::size_t memoryUsage() const override;
+
+  void releasePayload() override;
+
 private:
   BasicGraphicsScene* _scene;
 
@@ -43,7 +89,9 @@ private:
 };
 
 
-class ConnectCommand : public QUndoCommand
+class ConnectCommand
+  : public QUndoCommand
+  , public UndoPayload
 {
 public:
   ConnectCommand(BasicGraphicsScene* scene,
@@ -52,6 +100,10 @@ public:
   void undo() override;
   void redo() override;
 
+  std::size_t memoryUsage() const override;
+
+  void releasePayload() override;
+
 private:
   BasicGraphicsScene* _scene;
 
@@ -59,12 +111,21 @@ private:
 };
 
 
-class MoveNodeCommand : public QUndoCommand
+/// Moves a set of nodes by one common offset.
+/**
+ * Pushed for every mouse move of a drag. Consecutive commands are
+ * merged only when they belong to the same drag gesture and move the
+ * same set of nodes.
+ */
+class MoveNodesCommand
+  : public QUndoCommand
+  , public UndoPayload
 {
 public:
-  MoveNodeCommand(BasicGraphicsScene* scene,
-                  NodeId const nodeId,
-                  QPointF const &diff);
+  MoveNodesCommand(BasicGraphicsScene* scene,
+                   std::unordered_set<NodeId> nodeIds,
+                   QPointF const &diff,
+                   int const gesture);
 
   void undo() override;
   void redo() override;
@@ -73,10 +134,15 @@ public:
 
   bool mergeWith(QUndoCommand const *c) override;
 
+  std::size_t memoryUsage() const override;
+
+  void releasePayload() override;
+
 private:
   BasicGraphicsScene* _scene;
-  NodeId _nodeId;
+  std::unordered_set<NodeId> _nodeIds;
   QPointF _diff;
+  int _gesture;
 };
 
 
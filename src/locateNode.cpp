@@ -5,6 +5,7 @@
 #include <QtCore/QList>
 #include <QtWidgets/QGraphicsScene>
 
+#include "BasicGraphicsScene.hpp"
 #include "NodeGraphicsObject.hpp"
 
 
@@ -16,6 +17,12 @@ locateNodeAt(QPointF scenePoint,
              QGraphicsScene &scene,
              QTransform const & viewTransform)
 {
+  // Node scenes answer the query from their spatial index. The view
+  // transform only matters for items ignoring transformations, which
+  // nodes never do.
+  if (auto basicScene = dynamic_cast<BasicGraphicsScene*>(&scene))
+    return basicScene->nodeAt(scenePoint);
+
   // items under cursor
   QList<QGraphicsItem*> items =
     scene.items(scenePoint,
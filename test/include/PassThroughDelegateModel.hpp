@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+#include <QtNodes/NodeDelegateModel>
+
+/// One input and one output port of the same type, no data.
+class PassThroughDelegateModel : public QtNodes::NodeDelegateModel
+{
+public:
+  static QString Name() { return QStringLiteral("PassThrough"); }
+
+  QString caption() const override { return Name(); }
+
+  QString name() const override { return Name(); }
+
+  unsigned int nPorts(QtNodes::PortType) const override { return 1; }
+
+  QtNodes::NodeDataType
+  dataType(QtNodes::PortType, QtNodes::PortIndex) const override
+  {
+    return QtNodes::NodeDataType{"data", "Data"};
+  }
+
+  void
+  setInData(std::shared_ptr<QtNodes::NodeData>, QtNodes::PortIndex const) override
+  {
+  }
+
+  std::shared_ptr<QtNodes::NodeData>
+  outData(QtNodes::PortIndex const) override
+  {
+    return nullptr;
+  }
+
+  QWidget* embeddedWidget() override { return nullptr; }
+};
@@ -0,0 +1,227 @@
+#include "ApplicationSetup.hpp"
+#include "PassThroughDelegateModel.hpp"
+
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/StyleCollection>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::GraphCompression;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::NodeStyle;
+using QtNodes::StyleCollection;
+
+namespace
+{
+
+QByteArray
+saveToBytes(DataFlowGraphModel const & model,
+            QJsonDocument::JsonFormat format = QJsonDocument::Indented)
+{
+  QByteArray bytes;
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+
+  REQUIRE(model.save(buffer, GraphCompression::None, format));
+
+  return bytes;
+}
+
+
+/// Compact records of a JSON array, independent of the element order.
+std::multiset<QByteArray>
+records(QJsonArray const & array)
+{
+  std::multiset<QByteArray> result;
+
+  for (QJsonValue const value : array)
+    result.insert(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+
+  return result;
+}
+
+
+/// Checks the streamed output against the one-shot `save()`.
+void
+checkSameGraph(QByteArray const & bytes, DataFlowGraphModel const & model)
+{
+  QJsonParseError error;
+  QJsonObject const streamed = QJsonDocument::fromJson(bytes, &error).object();
+
+  REQUIRE(error.error == QJsonParseError::NoError);
+
+  QJsonObject const full = model.save().object();
+
+  CHECK(records(streamed["nodes"].toArray()) == records(full["nodes"].toArray()));
+  CHECK(records(streamed["connections"].toArray()) ==
+        records(full["connections"].toArray()));
+}
+
+
+/// A chain of `count` nodes, every node feeds the next one.
+void
+buildChain(DataFlowGraphModel & model, int count)
+{
+  NodeId previous = QtNodes::InvalidNodeId;
+
+  for (int i = 0; i < count; ++i)
+  {
+    NodeId const nodeId = model.addNode(PassThroughDelegateModel::Name());
+
+    model.setNodeData(nodeId, NodeRole::Position, QPointF(i * 200.0, 0.0));
+
+    if (previous != QtNodes::InvalidNodeId)
+      model.addConnection(ConnectionId{previous, 0, nodeId, 0});
+
+    previous = nodeId;
+  }
+}
+
+}
+
+TEST_CASE("Reconcile adds edges from an output port keeping another edge",
+          "[model]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  NodeId const a = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const b = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const c = model.addNode(PassThroughDelegateModel::Name());
+
+  ConnectionId const toB{a, 0, b, 0};
+  ConnectionId const toC{a, 0, c, 0};
+
+  model.addConnection(toB);
+  model.addConnection(toC);
+
+  QJsonDocument const target = model.save();
+
+  model.deleteConnection(toC);
+
+  REQUIRE_FALSE(model.connectionExists(toC));
+
+  // A.out0 still feeds B, the edge to C must be added back.
+  model.reconcile(target);
+
+  CHECK(model.connectionExists(toB));
+  CHECK(model.connectionExists(toC));
+}
+
+
+TEST_CASE("Node styles are served from the palette", "[model]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  NodeId const a = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const b = model.addNode(PassThroughDelegateModel::Name());
+
+  CHECK(model.nodeData(a, NodeRole::StyleIndex).toInt() == 0);
+
+  std::vector<NodeId> changed;
+
+  QObject::connect(&model, &DataFlowGraphModel::nodeStyleChanged,
+                   [&](NodeId const nodeId) { changed.push_back(nodeId); });
+
+  NodeStyle style = StyleCollection::nodeStyle();
+  style.NormalBoundaryColor = QColor(12, 34, 56);
+
+  model.delegateModel<PassThroughDelegateModel>(a)->setNodeStyle(style);
+  model.delegateModel<PassThroughDelegateModel>(b)->setNodeStyle(style);
+
+  CHECK(changed == std::vector<NodeId>{a, b});
+
+  int const handle = model.nodeData(a, NodeRole::StyleIndex).toInt();
+
+  CHECK(handle != 0);
+  CHECK(model.nodeData(b, NodeRole::StyleIndex).toInt() == handle);
+  CHECK(StyleCollection::nodeStyle(handle).NormalBoundaryColor == QColor(12, 34, 56));
+}
+
+
+TEST_CASE("Saving with cached records matches a full save", "[model]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  buildChain(model, 20);
+
+  for (auto format : {QJsonDocument::Indented, QJsonDocument::Compact})
+  {
+    // The first save fills the cache, the second splices every record.
+    checkSameGraph(saveToBytes(model, format), model);
+
+    QByteArray const cached = saveToBytes(model, format);
+    checkSameGraph(cached, model);
+
+    model.setNodeData(3, NodeRole::Position, QPointF(-50.0, 75.0));
+
+    QByteArray const partial = saveToBytes(model, format);
+    checkSameGraph(partial, model);
+
+    CHECK(partial != cached);
+
+    // A fresh model serializes every node from scratch.
+    DataFlowGraphModel fresh(registry);
+    fresh.load(QJsonDocument::fromJson(partial));
+
+    checkSameGraph(saveToBytes(fresh, format), model);
+  }
+}
+
+
+TEST_CASE("Re-saving one dirty node out of 50k", "[.][benchmark]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  buildChain(model, 50000);
+
+  QElapsedTimer timer;
+
+  timer.start();
+  saveToBytes(model);
+  qint64 const fullSave = timer.nsecsElapsed();
+
+  model.setNodeData(25000, NodeRole::Position, QPointF(1.0, 1.0));
+
+  timer.restart();
+  saveToBytes(model);
+  qint64 const incrementalSave = timer.nsecsElapsed();
+
+  WARN("Full save: " << fullSave / 1000000.0 << " ms, "
+       "one dirty node: " << incrementalSave / 1000000.0 << " ms");
+}
@@ -0,0 +1,197 @@
+#include <catch2/catch.hpp>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRectF>
+
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "SpatialIndex.hpp"
+
+
+using QtNodes::SpatialIndex;
+
+namespace
+{
+
+/// Random rectangles of node and connection sizes, some of them long.
+std::unordered_map<int, QRectF>
+randomRects(int count, qreal extent, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+
+  std::uniform_real_distribution<qreal> position(-extent, extent);
+  std::uniform_real_distribution<qreal> size(10.0, 300.0);
+  std::uniform_int_distribution<int> longOne(0, 20);
+
+  std::unordered_map<int, QRectF> rects;
+
+  for (int i = 0; i < count; ++i)
+  {
+    qreal const stretch = (longOne(generator) == 0) ? 40.0 : 1.0;
+
+    rects[i] = QRectF(position(generator), position(generator),
+                      size(generator) * stretch, size(generator));
+  }
+
+  return rects;
+}
+
+
+std::set<int>
+queried(SpatialIndex<int> const & index, QRectF const & rect)
+{
+  std::set<int> keys;
+
+  index.query(rect,
+              [&](int const key, QRectF const &)
+              {
+                // Every item is reported once.
+                CHECK(keys.insert(key).second);
+              });
+
+  return keys;
+}
+
+
+std::set<int>
+bruteForce(std::unordered_map<int, QRectF> const & rects, QRectF const & rect)
+{
+  std::set<int> keys;
+
+  for (auto const & entry : rects)
+  {
+    if (entry.second.intersects(rect))
+      keys.insert(entry.first);
+  }
+
+  return keys;
+}
+
+}
+
+
+TEST_CASE("SpatialIndex rect queries match a brute-force scan", "[index]")
+{
+  auto rects = randomRects(2000, 20000.0, 7);
+
+  SpatialIndex<int> index;
+
+  for (auto const & entry : rects)
+    index.insert(entry.first, entry.second);
+
+  std::vector<QRectF> const queries{
+    QRectF(0.0, 0.0, 500.0, 500.0),
+    QRectF(-3000.0, 1200.0, 4000.0, 250.0),
+    QRectF(-100.0, -100.0, 1.0, 1.0),
+    // Larger than the populated area, the occupied cells are walked.
+    QRectF(-1e7, -1e7, 2e7, 2e7),
+    QRectF(-1e12, -1e12, 2e12, 2e12),
+  };
+
+  SECTION("after insertion")
+  {
+    for (QRectF const & query : queries)
+      CHECK(queried(index, query) == bruteForce(rects, query));
+  }
+
+  SECTION("after moves and removals")
+  {
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<qreal> offset(-2000.0, 2000.0);
+
+    for (int key = 0; key < 2000; key += 3)
+    {
+      rects[key].translate(offset(generator), offset(generator));
+      index.insert(key, rects[key]);
+    }
+
+    for (int key = 1; key < 2000; key += 7)
+    {
+      rects.erase(key);
+      index.remove(key);
+    }
+
+    CHECK(index.size() == rects.size());
+
+    for (QRectF const & query : queries)
+      CHECK(queried(index, query) == bruteForce(rects, query));
+  }
+}
+
+
+TEST_CASE("SpatialIndex point queries match a brute-force scan", "[index]")
+{
+  auto const rects = randomRects(2000, 5000.0, 3);
+
+  SpatialIndex<int> index;
+
+  for (auto const & entry : rects)
+    index.insert(entry.first, entry.second);
+
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<qreal> position(-5000.0, 5000.0);
+
+  for (int i = 0; i < 200; ++i)
+  {
+    QPointF const point(position(generator), position(generator));
+
+    std::set<int> keys;
+
+    index.query(point,
+                [&](int const key, QRectF const &)
+                {
+                  keys.insert(key);
+                });
+
+    std::set<int> expected;
+
+    for (auto const & entry : rects)
+    {
+      if (entry.second.contains(point))
+        expected.insert(entry.first);
+    }
+
+    CHECK(keys == expected);
+  }
+}
+
+
+TEST_CASE("SpatialIndex query over 100k items", "[.][benchmark]")
+{
+  auto const rects = randomRects(100000, 200000.0, 13);
+
+  SpatialIndex<int> index;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (auto const & entry : rects)
+    index.insert(entry.first, entry.second);
+
+  qint64 const insertion = timer.nsecsElapsed();
+
+  QRectF const viewport(0.0, 0.0, 1920.0, 1080.0);
+
+  timer.restart();
+  std::size_t const visible = queried(index, viewport).size();
+  qint64 const viewportQuery = timer.nsecsElapsed();
+
+  timer.restart();
+  std::size_t const all = queried(index, QRectF(-1e9, -1e9, 2e9, 2e9)).size();
+  qint64 const zoomedOutQuery = timer.nsecsElapsed();
+
+  timer.restart();
+  std::size_t const scanned = bruteForce(rects, viewport).size();
+  qint64 const scan = timer.nsecsElapsed();
+
+  CHECK(visible == scanned);
+  CHECK(all == rects.size());
+
+  WARN("Insertion: " << insertion / 1000000.0 << " ms, "
+       "viewport query: " << viewportQuery / 1000.0 << " us, "
+       "zoomed-out query: " << zoomedOutQuery / 1000000.0 << " ms, "
+       "brute-force scan: " << scan / 1000.0 << " us");
+}
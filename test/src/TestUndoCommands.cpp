@@ -0,0 +1,203 @@
+#include "ApplicationSetup.hpp"
+#include "PassThroughDelegateModel.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/NodeGraphicsObject>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QUndoStack>
+
+#include <memory>
+#include <vector>
+
+#include "UndoCommands.hpp"
+
+
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectCommand;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::DeleteCommand;
+using QtNodes::DisconnectCommand;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+
+namespace
+{
+
+/// A chain of `count` nodes, every node feeds the next one.
+std::vector<ConnectionId>
+buildChain(DataFlowGraphModel & model, int count)
+{
+  std::vector<ConnectionId> connections;
+
+  NodeId previous = QtNodes::InvalidNodeId;
+
+  for (int i = 0; i < count; ++i)
+  {
+    NodeId const nodeId = model.addNode(PassThroughDelegateModel::Name());
+
+    model.setNodeData(nodeId, NodeRole::Position, QPointF(i * 200.0, 0.0));
+
+    if (previous != QtNodes::InvalidNodeId)
+    {
+      connections.push_back(ConnectionId{previous, 0, nodeId, 0});
+      model.addConnection(connections.back());
+    }
+
+    previous = nodeId;
+  }
+
+  return connections;
+}
+
+
+void
+selectAllNodes(BasicGraphicsScene & scene, DataFlowGraphModel const & model)
+{
+  for (NodeId const nodeId : model.allNodeIds())
+    scene.nodeGraphicsObject(nodeId)->setSelected(true);
+}
+
+}
+
+TEST_CASE("Undoing a delete restores edges sharing a surviving output port",
+          "[undo]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  NodeId const a = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const b = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const c = model.addNode(PassThroughDelegateModel::Name());
+
+  // A.out0 feeds both B and C.
+  ConnectionId const toB{a, 0, b, 0};
+  ConnectionId const toC{a, 0, c, 0};
+
+  model.addConnection(toB);
+  model.addConnection(toC);
+
+  BasicGraphicsScene scene(model);
+
+  scene.nodeGraphicsObject(b)->setSelected(true);
+
+  scene.undoStack().push(new DeleteCommand(&scene));
+
+  CHECK_FALSE(model.nodeExists(b));
+  CHECK_FALSE(model.connectionExists(toB));
+  CHECK(model.connectionExists(toC));
+
+  scene.undoStack().undo();
+
+  CHECK(model.nodeExists(b));
+  CHECK(model.connectionExists(toB));
+  CHECK(model.connectionExists(toC));
+  CHECK(scene.connectionGraphicsObject(toB) != nullptr);
+}
+
+
+TEST_CASE("Undoing a delete of many nodes restores the whole graph", "[undo]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  std::vector<ConnectionId> const connections = buildChain(model, 100);
+
+  BasicGraphicsScene scene(model);
+
+  selectAllNodes(scene, model);
+
+  scene.undoStack().push(new DeleteCommand(&scene));
+
+  CHECK(model.allNodeIds().empty());
+
+  scene.undoStack().undo();
+
+  CHECK(model.allNodeIds().size() == 100);
+
+  for (ConnectionId const & connectionId : connections)
+    CHECK(model.connectionExists(connectionId));
+
+  CHECK(model.nodeData(42, NodeRole::Position).value<QPointF>() == QPointF(42 * 200.0, 0.0));
+}
+
+
+TEST_CASE("Connection commands count against the undo memory budget", "[undo]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  NodeId const a = model.addNode(PassThroughDelegateModel::Name());
+  NodeId const b = model.addNode(PassThroughDelegateModel::Name());
+
+  ConnectionId const connectionId{a, 0, b, 0};
+
+  BasicGraphicsScene scene(model);
+
+  scene.undoStack().push(new ConnectCommand(&scene, connectionId));
+  scene.undoStack().push(new DisconnectCommand(&scene, connectionId));
+  scene.undoStack().push(new ConnectCommand(&scene, connectionId));
+
+  CHECK(model.connectionExists(connectionId));
+  CHECK(scene.undoMemoryUsage() ==
+        qint64(2 * sizeof(ConnectCommand) + sizeof(DisconnectCommand)));
+
+  // Everything but the newest command is evicted.
+  scene.setUndoMemoryBudget(1);
+
+  CHECK(scene.undoMemoryUsage() == qint64(sizeof(ConnectCommand)));
+
+  scene.undoStack().undo();
+
+  CHECK_FALSE(model.connectionExists(connectionId));
+}
+
+
+TEST_CASE("Undoing a 2k-node delete", "[.][benchmark]")
+{
+  auto setup = applicationSetup();
+
+  auto registry = std::make_shared<NodeDelegateModelRegistry>();
+  registry->registerModel<PassThroughDelegateModel>();
+
+  DataFlowGraphModel model(registry);
+
+  buildChain(model, 2000);
+
+  BasicGraphicsScene scene(model);
+
+  selectAllNodes(scene, model);
+
+  QElapsedTimer timer;
+
+  timer.start();
+  scene.undoStack().push(new DeleteCommand(&scene));
+  qint64 const deletion = timer.nsecsElapsed();
+
+  timer.restart();
+  scene.undoStack().undo();
+  qint64 const undo = timer.nsecsElapsed();
+
+  CHECK(model.allNodeIds().size() == 2000);
+
+  WARN("Delete: " << deletion / 1000000.0 << " ms, "
+       "undo: " << undo / 1000000.0 << " ms");
+}